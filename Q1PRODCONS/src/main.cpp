@@ -4,14 +4,34 @@
 #include <thread>     // Enables creation and management of multiple threads (producers and consumers).
 #include <vector>     // Used to store multiple threads in a resizable array.
 #include <queue>      // Provides the queue data structure for the shared buffer.
-#include <random>     // Used to generate random numbers for sales records.
+#include <deque>      // Provides the per-consumer deques of the work-stealing buffer.
+#include <random>     // Provides std::random_device for picking a seed when none is given.
 #include <mutex>      // Provides mutexes to ensure thread-safe access to shared resources.
 #include <condition_variable> // Synchronizes threads using condition variables for producer-consumer communication.
 #include <chrono>     // Used to measure time and create delays in thread execution.
 #include <atomic>     // Provides atomic variables to safely share data between threads.
 #include <iomanip>    // Used for precise formatting of floating-point numbers in output.
-#include <unordered_map> // Provides hash maps for fast lookup of statistics (store-wise and month-wise sales).
+#include <array>      // Provides fixed-size arrays for month-wise statistics.
+#include <map>        // Provides ordered totals for store IDs outside the flat arrays.
 #include <filesystem> // Used to manage file system tasks like creating directories.
+#include <memory>     // Provides std::unique_ptr for owning the selected buffer backend.
+#include <cstring>    // Provides std::strcmp for parsing command-line options.
+#include <cstdlib>    // Provides std::atoi/std::strtoull for parsing numeric command-line options.
+#include <cstdint>    // Provides fixed-width integers for the random number generator state.
+#include <cctype>     // Provides std::isspace for reading sweep config files.
+#include <algorithm>  // Provides std::min/std::max for sizing batches.
+#include <sstream>    // Provides per-run log buffers and list parsing for the parameter sweep.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h> // Provides _mm_pause for spin-wait loops on x86.
+#endif
+#ifdef _WIN32
+#include <iterator>   // Provides std::istreambuf_iterator for the non-mmap sales log fallback.
+#else
+#include <fcntl.h>    // Provides open() for memory-mapped sales logs.
+#include <sys/mman.h> // Provides mmap()/munmap() for memory-mapped sales logs.
+#include <sys/stat.h> // Provides fstat() to size a mapped file.
+#include <unistd.h>   // Provides close()/ftruncate() for memory-mapped sales logs.
+#endif
 
 namespace fs = std::filesystem; // Shortens the namespace to make filesystem operations more convenient.
 
@@ -20,162 +40,1756 @@ struct SalesRecord {
     int day, month, year;    // Sales date: day, month, and year.
     int storeID, registerNum; // Store ID and register number of the sales transaction.
     float saleAmount;         // The amount of the sale.
+    int64_t enqueueTime = 0;  // When a producer handed the record to the buffer (ns, steady clock); only set when measuring latency.
 };
 
-// Class representing a thread-safe shared buffer for storing sales records.
-class SharedBuffer {
+// On-disk form of a sales record in a binary sales log: 12 bytes, fixed width, little-endian.
+// The date is packed into 16 bits (day: 5, month: 4, year % 128: 7) and the amount is stored in cents.
+struct PackedSalesRecord {
+    uint32_t storeID;     // Store ID.
+    uint32_t amountCents; // Sale amount in cents.
+    uint16_t date;        // day | month << 5 | year << 9.
+    uint8_t registerNum;  // Register number.
+    uint8_t reserved;     // Padding (always 0).
+};
+static_assert(sizeof(PackedSalesRecord) == 12, "PackedSalesRecord must stay 12 bytes");
+
+// Header at the start of every binary sales log; records follow immediately after it.
+struct SalesLogHeader {
+    char magic[8];        // "SALESLOG".
+    uint32_t version;     // Format version (1).
+    uint32_t recordSize;  // sizeof(PackedSalesRecord), so readers can reject foreign layouts.
+    uint64_t recordCount; // Number of records that follow.
+    uint64_t reserved;    // Padding (always 0).
+};
+static_assert(sizeof(SalesLogHeader) == 32, "SalesLogHeader must stay 32 bytes");
+
+constexpr char SALES_LOG_MAGIC[8] = {'S', 'A', 'L', 'E', 'S', 'L', 'O', 'G'};
+constexpr uint32_t SALES_LOG_VERSION = 1;
+
+// Convert a record to its on-disk form.
+inline PackedSalesRecord packRecord(const SalesRecord &record) {
+    PackedSalesRecord packed;
+    packed.storeID = static_cast<uint32_t>(record.storeID);
+    packed.amountCents = static_cast<uint32_t>(record.saleAmount * 100.0f + 0.5f);
+    packed.date = static_cast<uint16_t>((record.day & 0x1F) | (record.month & 0x0F) << 5 | (record.year & 0x7F) << 9);
+    packed.registerNum = static_cast<uint8_t>(record.registerNum);
+    packed.reserved = 0;
+    return packed;
+}
+
+// Convert an on-disk record back to a SalesRecord.
+inline SalesRecord unpackRecord(const PackedSalesRecord &packed) {
+    SalesRecord record;
+    record.day = packed.date & 0x1F;
+    record.month = (packed.date >> 5) & 0x0F;
+    record.year = packed.date >> 9;
+    record.storeID = static_cast<int>(packed.storeID);
+    record.registerNum = packed.registerNum;
+    record.saleAmount = static_cast<float>(packed.amountCents) / 100.0f;
+    return record;
+}
+
+// Current steady-clock time in nanoseconds (used for latency stamps).
+inline int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Hot-path counters for one thread's use of the buffer. Each producer/consumer owns one and points
+// threadCounters at it, so the buffer records into thread-private memory with plain increments;
+// runSimulation merges them once the threads are done. Clocks are only read when a thread actually waits.
+struct BufferCounters {
+    static constexpr int OCCUPANCY_BUCKETS = 11; // Buffer fill level in 10% steps (0%, 10%, ..., 100%).
+    uint64_t waitNanos = 0;       // Time spent blocked (full buffer for producers, empty buffer for consumers).
+    uint64_t waits = 0;           // Number of operations that had to block.
+    uint64_t lockAttempts = 0;    // try_lock calls (mutex backend) or claim CAS attempts (lock-free backend).
+    uint64_t failedTryLocks = 0;  // Attempts that lost to another thread.
+    uint64_t operations = 0;      // Buffer calls that moved at least one record.
+    uint64_t records = 0;         // Records moved.
+    uint64_t steals = 0;          // Records a consumer took from another consumer's deque (work-stealing backend).
+    std::array<uint64_t, OCCUPANCY_BUCKETS> occupancy{}; // Fill level seen after each operation.
+
+    // Record the fill level after an operation.
+    void noteOccupancy(size_t used, size_t capacity) {
+        size_t bucket = capacity == 0 ? 0 : std::min(used, capacity) * (OCCUPANCY_BUCKETS - 1) / capacity;
+        occupancy[bucket]++;
+    }
+
+    void merge(const BufferCounters &other) {
+        waitNanos += other.waitNanos;
+        waits += other.waits;
+        lockAttempts += other.lockAttempts;
+        failedTryLocks += other.failedTryLocks;
+        operations += other.operations;
+        records += other.records;
+        steals += other.steals;
+        for (int i = 0; i < OCCUPANCY_BUCKETS; ++i) {
+            occupancy[i] += other.occupancy[i];
+        }
+    }
+};
+
+thread_local BufferCounters *threadCounters = nullptr; // Counters of the calling thread (null = not instrumented).
+
+// Measures how long an operation blocks. begin() is called when the thread first has to wait;
+// the elapsed time is charged to the thread's counters when the operation completes.
+class WaitTimer {
+private:
+    BufferCounters *counters = threadCounters;
+    int64_t start = 0;
+
+public:
+    void begin() {
+        if (counters && start == 0) {
+            start = nowNanos();
+        }
+    }
+
+    ~WaitTimer() {
+        if (counters && start != 0) {
+            counters->waitNanos += static_cast<uint64_t>(nowNanos() - start);
+            counters->waits++;
+        }
+    }
+};
+
+// Interface shared by all buffer backends so producers, consumers and runSimulation don't care which one is used.
+class RecordBuffer {
+public:
+    virtual ~RecordBuffer() = default;
+    virtual void produce(const SalesRecord &record) = 0;                 // Add a record, blocking while the buffer is full.
+    virtual SalesRecord consume(std::atomic<bool> &terminate) = 0;       // Remove a record, blocking while the buffer is empty.
+    virtual void produceBatch(const SalesRecord *records, size_t count) = 0; // Add 'count' records, blocking while the buffer is full.
+    virtual size_t consumeBatch(SalesRecord *out, size_t max, std::atomic<bool> &terminate) = 0; // Remove 1..max records; 0 means terminated and empty.
+    virtual bool isEmpty() = 0;                                          // Check whether the buffer currently holds no records.
+    virtual size_t size() = 0;                                           // Records currently buffered (a snapshot, for reporting).
+    virtual size_t capacity() const = 0;                                 // Most records the buffer can hold.
+    virtual void notifyAllDone() = 0;                                    // Wake every blocked consumer so it can observe termination.
+};
+
+// Class representing a thread-safe shared buffer for storing sales records (mutex + condition variable backend).
+class SharedBuffer : public RecordBuffer {
+private:
+    std::queue<SalesRecord> buffer;          // The buffer implemented as a queue to store records.
+    size_t maxSize;                          // The maximum number of items the buffer can hold.
+    std::mutex mtx;                          // Mutex to ensure thread-safe access to the buffer.
+    std::condition_variable cvFull, cvEmpty; // Condition variables for producer-consumer synchronization.
+
+    // Lock the mutex, trying without blocking first so contention shows up in the counters.
+    std::unique_lock<std::mutex> acquire() {
+        std::unique_lock<std::mutex> lock(mtx, std::try_to_lock);
+        BufferCounters *counters = threadCounters;
+        if (counters) {
+            counters->lockAttempts++;
+        }
+        if (!lock.owns_lock()) {
+            if (counters) {
+                counters->failedTryLocks++;
+            }
+            lock.lock();
+        }
+        return lock;
+    }
+
+    // Wait on 'cv' until 'ready' holds, timing the wait only if one is needed.
+    template <typename Predicate>
+    void waitFor(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, Predicate ready) {
+        if (ready()) {
+            return;
+        }
+        WaitTimer timer;
+        timer.begin();
+        cv.wait(lock, ready);
+    }
+
+    // Charge a completed operation to the calling thread.
+    void noteOperation(size_t records) {
+        if (BufferCounters *counters = threadCounters) {
+            counters->operations++;
+            counters->records += records;
+            counters->noteOccupancy(buffer.size(), maxSize);
+        }
+    }
+
+public:
+    // Constructor to initialize the buffer with a given size.
+    SharedBuffer(size_t size) : maxSize(size) {}
+
+    // Producer function to add a record to the buffer.
+    void produce(const SalesRecord &record) override {
+        std::unique_lock<std::mutex> lock = acquire(); // Lock the mutex to access the buffer.
+        waitFor(cvFull, lock, [this]() { return buffer.size() < maxSize; }); // Wait if the buffer is full.
+        buffer.push(record); // Add the sales record to the buffer.
+        noteOperation(1);
+        cvEmpty.notify_one(); // Notify one waiting consumer that a new item is available.
+    }
+
+    // Consumer function to retrieve a record from the buffer.
+    SalesRecord consume(std::atomic<bool> &terminate) override {
+        std::unique_lock<std::mutex> lock = acquire(); // Lock the mutex to access the buffer.
+        waitFor(cvEmpty, lock, [this, &terminate]() { return !buffer.empty() || terminate; }); // Wait if the buffer is empty.
+
+        if (terminate && buffer.empty()) {
+            return {}; // Return an empty record if no more items are available and termination is signaled.
+        }
+
+        SalesRecord record = buffer.front(); // Get the front record in the buffer.
+        buffer.pop(); // Remove the record from the buffer.
+        noteOperation(1);
+        cvFull.notify_one(); // Notify one waiting producer that space is now available.
+        return record;
+    }
+
+    // Producer function to add several records, moving as many as fit per lock acquisition.
+    void produceBatch(const SalesRecord *records, size_t count) override {
+        while (count > 0) {
+            std::unique_lock<std::mutex> lock = acquire(); // Lock the mutex once for this chunk of the batch.
+            waitFor(cvFull, lock, [this]() { return buffer.size() < maxSize; }); // Wait if the buffer is full.
+            size_t n = std::min(count, maxSize - buffer.size()); // Move as many records as there is room for.
+            for (size_t i = 0; i < n; ++i) {
+                buffer.push(records[i]);
+            }
+            noteOperation(n);
+            records += n;
+            count -= n;
+            if (n == 1) {
+                cvEmpty.notify_one(); // One record: one consumer is enough.
+            } else {
+                cvEmpty.notify_all(); // Several records: let every waiting consumer take some.
+            }
+        }
+    }
+
+    // Consumer function to retrieve up to 'max' records with a single lock acquisition.
+    size_t consumeBatch(SalesRecord *out, size_t max, std::atomic<bool> &terminate) override {
+        std::unique_lock<std::mutex> lock = acquire(); // Lock the mutex to access the buffer.
+        waitFor(cvEmpty, lock, [this, &terminate]() { return !buffer.empty() || terminate; }); // Wait if the buffer is empty.
+
+        size_t n = std::min(max, buffer.size()); // Zero only when termination is signaled and the buffer is empty.
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = buffer.front();
+            buffer.pop();
+        }
+        if (n > 0) {
+            noteOperation(n);
+        }
+        if (n == 1) {
+            cvFull.notify_one(); // One slot freed: wake one producer.
+        } else if (n > 1) {
+            cvFull.notify_all(); // Several slots freed: wake every waiting producer.
+        }
+        return n;
+    }
+
+    // Function to check if the buffer is empty.
+    bool isEmpty() override {
+        std::lock_guard<std::mutex> lock(mtx); // Lock the mutex for thread-safe access.
+        return buffer.empty(); // Return true if the buffer is empty.
+    }
+
+    size_t size() override {
+        std::lock_guard<std::mutex> lock(mtx);
+        return buffer.size();
+    }
+
+    size_t capacity() const override { return maxSize; }
+
+    // Function to notify all waiting consumers that production is complete.
+    void notifyAllDone() override {
+        std::unique_lock<std::mutex> lock(mtx); // Lock the mutex.
+        cvEmpty.notify_all(); // Notify all consumers waiting on cvEmpty.
+    }
+};
+
+// Hint to the CPU that we are inside a spin-wait loop.
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Size of a cache line; used to keep hot atomics on separate lines and avoid false sharing.
+constexpr size_t CACHE_LINE = 64;
+
+// A place for threads to sleep once spinning has not paid off.
+// Waiters announce themselves through the 'waiters' counter so the other side only
+// pays for a mutex + notify when somebody is actually parked.
+struct alignas(CACHE_LINE) ParkingLot {
+    std::mutex mtx;                 // Protects the sleep/wake handshake.
+    std::condition_variable cv;     // Parked threads wait here.
+    std::atomic<int> waiters{0};    // Number of threads currently parked (or about to park).
+
+    // Wake one parked thread, if any. Must be called after the state change it signals.
+    void wakeOne() {
+        std::atomic_thread_fence(std::memory_order_seq_cst); // Order the state change before reading 'waiters'.
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(mtx); // Taking the lock closes the window between a waiter's check and its wait.
+            cv.notify_one();
+        }
+    }
+
+    // Wake every parked thread, if any (used for batches and termination).
+    void wakeAll() {
+        std::atomic_thread_fence(std::memory_order_seq_cst); // Same ordering as wakeOne.
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            cv.notify_all();
+        }
+    }
+
+    // Park until 'ready()' returns true. 'ready' is re-evaluated under the lock, so no wakeup is lost.
+    template <typename Predicate>
+    void park(Predicate ready) {
+        waiters.fetch_add(1, std::memory_order_seq_cst); // Announce ourselves before the final check.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, ready);
+        }
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+};
+
+// Lock-free bounded multi-producer/multi-consumer ring buffer (Vyukov-style).
+// Each slot carries a sequence number that tells producers and consumers whose turn it is,
+// so the only shared writes are one CAS on 'tail' (producers) or 'head' (consumers).
+// The capacity is rounded up to a power of two so slot lookup is a mask instead of a modulo.
+// Blocking uses spin-then-park: spin briefly, then sleep in a ParkingLot.
+class LockFreeBuffer : public RecordBuffer {
+private:
+    struct Slot {
+        std::atomic<size_t> sequence; // Ticket that says whether the slot is ready for a producer or a consumer.
+        SalesRecord record;           // The stored sales record.
+    };
+
+    const int SPIN_LIMIT = std::thread::hardware_concurrency() > 1 ? 256 : 0; // Failed attempts before parking (spinning is pointless on one core).
+
+    std::vector<Slot> slots;                     // Ring storage.
+    size_t mask;                                 // capacity - 1, used to wrap positions into slot indexes.
+    alignas(CACHE_LINE) std::atomic<size_t> tail{0}; // Next position to write (producers).
+    alignas(CACHE_LINE) std::atomic<size_t> head{0}; // Next position to read (consumers).
+    ParkingLot notFull;                          // Producers park here while the ring is full.
+    ParkingLot notEmpty;                         // Consumers park here while the ring is empty.
+
+    // Charge a completed operation to the calling thread (occupancy is a racy but cheap estimate).
+    void noteOperation(size_t records) {
+        if (BufferCounters *counters = threadCounters) {
+            counters->operations++;
+            counters->records += records;
+            size_t used = tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed);
+            counters->noteOccupancy(static_cast<intptr_t>(used) < 0 ? 0 : used, slots.size());
+        }
+    }
+
+    // Round a requested size up to the next power of two (at least 2).
+    static size_t roundUpPow2(size_t size) {
+        size_t capacity = 2;
+        while (capacity < size) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+public:
+    // Constructor to initialize the ring with at least 'size' slots.
+    LockFreeBuffer(size_t size) : slots(roundUpPow2(size)), mask(slots.size() - 1) {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed); // Slot i is first writable at position i.
+        }
+    }
+
+    // Actual number of slots after rounding up.
+    size_t capacity() const override { return slots.size(); }
+
+    // Try to add a record without blocking. Returns false if the ring is full.
+    bool tryProduce(const SalesRecord &record) {
+        BufferCounters *counters = threadCounters;
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[pos & mask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) { // Slot is free for this position; try to claim it.
+                if (counters) {
+                    counters->lockAttempts++;
+                }
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.record = record;
+                    slot.sequence.store(pos + 1, std::memory_order_release); // Publish to consumers.
+                    return true;
+                }
+                if (counters) {
+                    counters->failedTryLocks++; // Lost the race for this position.
+                }
+            } else if (diff < 0) { // Slot still holds an unread record from the previous lap: full.
+                return false;
+            } else { // Another producer claimed this position; reload and retry.
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Try to remove a record without blocking. Returns false if the ring is empty.
+    bool tryConsume(SalesRecord &record) {
+        BufferCounters *counters = threadCounters;
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[pos & mask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) { // Slot holds a published record for this position; try to claim it.
+                if (counters) {
+                    counters->lockAttempts++;
+                }
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    record = slot.record;
+                    slot.sequence.store(pos + mask + 1, std::memory_order_release); // Hand the slot to the next lap's producer.
+                    return true;
+                }
+                if (counters) {
+                    counters->failedTryLocks++; // Lost the race for this position.
+                }
+            } else if (diff < 0) { // Nothing published here yet: empty.
+                return false;
+            } else { // Another consumer took this position; reload and retry.
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Producer function to add a record to the buffer (spins, then parks while full).
+    void produce(const SalesRecord &record) override {
+        WaitTimer timer;
+        for (int spin = 0; !tryProduce(record); ++spin) {
+            timer.begin();
+            if (spin < SPIN_LIMIT) {
+                cpuRelax();
+                continue;
+            }
+            bool stored = false;
+            notFull.park([&]() { return stored || (stored = tryProduce(record)); });
+            if (stored) {
+                break;
+            }
+        }
+        noteOperation(1);
+        notEmpty.wakeOne(); // Let a parked consumer know a record is available.
+    }
+
+    // Consumer function to retrieve a record from the buffer (spins, then parks while empty).
+    SalesRecord consume(std::atomic<bool> &terminate) override {
+        SalesRecord record{};
+        WaitTimer timer;
+        for (int spin = 0; !tryConsume(record); ++spin) {
+            timer.begin();
+            if (terminate.load(std::memory_order_acquire)) {
+                if (tryConsume(record)) { // Drain anything published before termination was signaled.
+                    break;
+                }
+                return {}; // Return an empty record if no more items are available and termination is signaled.
+            }
+            if (spin < SPIN_LIMIT) {
+                cpuRelax();
+                continue;
+            }
+            bool taken = false;
+            notEmpty.park([&]() { return taken || (taken = tryConsume(record)) || terminate.load(std::memory_order_acquire); });
+            if (taken) {
+                break;
+            }
+        }
+        noteOperation(1);
+        notFull.wakeOne(); // Let a parked producer know a slot is free.
+        return record;
+    }
+
+    // Producer function to add several records. The ring has no lock to amortize, so records still
+    // go through the per-slot protocol; what the batch saves is the wakeup, which happens once per batch.
+    void produceBatch(const SalesRecord *records, size_t count) override {
+        size_t unannounced = 0; // Records published since consumers were last woken.
+        for (size_t i = 0; i < count; ++i) {
+            WaitTimer timer;
+            for (int spin = 0; !tryProduce(records[i]); ++spin) {
+                timer.begin();
+                if (spin < SPIN_LIMIT) {
+                    cpuRelax();
+                    continue;
+                }
+                if (unannounced > 0) { // Never park while consumers might be asleep on our records.
+                    notEmpty.wakeAll();
+                    unannounced = 0;
+                }
+                bool stored = false;
+                notFull.park([&]() { return stored || (stored = tryProduce(records[i])); });
+                if (stored) {
+                    break;
+                }
+            }
+            ++unannounced;
+        }
+        if (count > 0) {
+            noteOperation(count);
+        }
+        if (unannounced == 1) {
+            notEmpty.wakeOne();
+        } else if (unannounced > 1) {
+            notEmpty.wakeAll();
+        }
+    }
+
+    // Consumer function to retrieve up to 'max' records: block for the first one, then take whatever else is ready.
+    size_t consumeBatch(SalesRecord *out, size_t max, std::atomic<bool> &terminate) override {
+        if (max == 0) {
+            return 0;
+        }
+        WaitTimer timer;
+        for (int spin = 0; !tryConsume(out[0]); ++spin) {
+            timer.begin();
+            if (terminate.load(std::memory_order_acquire)) {
+                if (tryConsume(out[0])) { // Drain anything published before termination was signaled.
+                    break;
+                }
+                return 0; // Terminated and empty.
+            }
+            if (spin < SPIN_LIMIT) {
+                cpuRelax();
+                continue;
+            }
+            bool taken = false;
+            notEmpty.park([&]() { return taken || (taken = tryConsume(out[0])) || terminate.load(std::memory_order_acquire); });
+            if (taken) {
+                break;
+            }
+        }
+        size_t n = 1;
+        while (n < max && tryConsume(out[n])) { // Take any further records without blocking.
+            ++n;
+        }
+        noteOperation(n);
+        if (n == 1) {
+            notFull.wakeOne();
+        } else {
+            notFull.wakeAll();
+        }
+        return n;
+    }
+
+    // Function to check if the buffer is empty (a snapshot; may be stale by the time it returns).
+    bool isEmpty() override {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    size_t size() override {
+        size_t used = tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(used) < 0 ? 0 : std::min(used, slots.size()); // Head can pass a stale tail read.
+    }
+
+    // Function to notify all waiting consumers that production is complete.
+    void notifyAllDone() override {
+        std::lock_guard<std::mutex> lock(notEmpty.mtx); // Unconditional: consumers may be between their check and park.
+        notEmpty.cv.notify_all();
+    }
+};
+
+// Work-stealing topology: every consumer owns a bounded deque instead of sharing one queue.
+// Producers route records to a deque (round-robin, or by storeID so a store always lands on the
+// same consumer); a consumer drains its own deque from the front and, when it runs dry, steals
+// up to half of another consumer's deque from the back. Each deque has its own lock, so threads
+// only contend when they touch the same deque.
+class WorkStealingBuffer : public RecordBuffer {
+private:
+    // One consumer's deque, on its own cache line(s).
+    struct alignas(CACHE_LINE) Lane {
+        std::mutex mtx;                    // Protects 'records'.
+        std::deque<SalesRecord> records;   // Pending records for this consumer.
+    };
+
+    std::vector<Lane> lanes;             // One deque per consumer.
+    size_t laneCapacity;                 // Maximum records per deque.
+    bool routeByStore;                   // Route by storeID instead of round-robin.
+    std::atomic<size_t> total{0};        // Records across all deques (used for parking decisions).
+    std::atomic<size_t> nextLane{0};     // Hands out deques to consumer threads on first use.
+    std::atomic<size_t> nextCursor{0};   // Staggers the round-robin starting point of producer threads.
+    ParkingLot notFull;                  // Producers park here while every deque is full.
+    ParkingLot notEmpty;                 // Consumers park here while every deque is empty.
+    const int SPIN_LIMIT = std::thread::hardware_concurrency() > 1 ? 64 : 0; // Empty passes before parking.
+
+    // Per-thread routing state: which buffer it belongs to, its own deque (consumers) and round-robin cursor (producers).
+    struct ThreadLane {
+        const WorkStealingBuffer *owner = nullptr;
+        size_t lane = 0;
+        size_t cursor = 0;
+    };
+    static ThreadLane &threadLane() {
+        thread_local ThreadLane state;
+        return state;
+    }
+
+    // This thread's state for this buffer, set up the first time the thread shows up.
+    // Consumers are given their own deque; producers only get a round-robin starting point.
+    ThreadLane &self(bool isConsumer) {
+        ThreadLane &state = threadLane();
+        if (state.owner != this) {
+            state.owner = this;
+            state.lane = isConsumer ? nextLane.fetch_add(1) % lanes.size() : 0;
+            state.cursor = nextCursor.fetch_add(1);
+        }
+        return state;
+    }
+
+    // Lock a deque, counting a failed try_lock as contention.
+    std::unique_lock<std::mutex> acquire(Lane &lane) {
+        std::unique_lock<std::mutex> lock(lane.mtx, std::try_to_lock);
+        BufferCounters *counters = threadCounters;
+        if (counters) {
+            counters->lockAttempts++;
+        }
+        if (!lock.owns_lock()) {
+            if (counters) {
+                counters->failedTryLocks++;
+            }
+            lock.lock();
+        }
+        return lock;
+    }
+
+    // Charge a completed operation to the calling thread.
+    void noteOperation(size_t records, size_t stolen) {
+        if (BufferCounters *counters = threadCounters) {
+            counters->operations++;
+            counters->records += records;
+            counters->steals += stolen;
+            counters->noteOccupancy(total.load(std::memory_order_relaxed), laneCapacity * lanes.size());
+        }
+    }
+
+    // Push as many of 'records' as fit, starting at deque 'start' and moving on when a deque is full.
+    size_t pushSome(const SalesRecord *records, size_t count, size_t start) {
+        size_t pushed = 0;
+        for (size_t k = 0; k < lanes.size() && pushed < count; ++k) {
+            Lane &lane = lanes[(start + k) % lanes.size()];
+            std::unique_lock<std::mutex> lock = acquire(lane);
+            size_t n = std::min(count - pushed, laneCapacity - lane.records.size());
+            lane.records.insert(lane.records.end(), records + pushed, records + pushed + n);
+            pushed += n;
+            total.fetch_add(n);
+        }
+        return pushed;
+    }
+
+    // Take up to 'max' records: from the front of our own deque, else steal from the back of another.
+    size_t popSome(SalesRecord *out, size_t max, size_t own, size_t &stolen) {
+        {
+            Lane &lane = lanes[own];
+            std::unique_lock<std::mutex> lock = acquire(lane);
+            size_t n = std::min(max, lane.records.size());
+            std::copy(lane.records.begin(), lane.records.begin() + n, out);
+            lane.records.erase(lane.records.begin(), lane.records.begin() + n);
+            if (n > 0) {
+                total.fetch_sub(n);
+                return n;
+            }
+        }
+        for (size_t k = 1; k < lanes.size(); ++k) {
+            Lane &victim = lanes[(own + k) % lanes.size()];
+            std::unique_lock<std::mutex> lock = acquire(victim);
+            size_t available = victim.records.size();
+            size_t n = std::min(max, (available + 1) / 2); // Take half, so the owner keeps working too.
+            if (n == 0) {
+                continue;
+            }
+            std::copy(victim.records.end() - n, victim.records.end(), out);
+            victim.records.erase(victim.records.end() - n, victim.records.end());
+            total.fetch_sub(n);
+            stolen = n;
+            return n;
+        }
+        return 0;
+    }
+
+public:
+    // Constructor: one deque of 'size' records for each of 'consumers' consumers.
+    WorkStealingBuffer(size_t size, int consumers, bool byStore)
+        : lanes(static_cast<size_t>(std::max(1, consumers))), laneCapacity(std::max<size_t>(1, size)), routeByStore(byStore) {}
+
+    // Producer function to add a record to the buffer.
+    void produce(const SalesRecord &record) override {
+        produceBatch(&record, 1);
+    }
+
+    // Consumer function to retrieve a record from the buffer.
+    SalesRecord consume(std::atomic<bool> &terminate) override {
+        SalesRecord record{};
+        consumeBatch(&record, 1, terminate);
+        return record; // Empty record if termination was signaled and every deque is empty.
+    }
+
+    // Producer function to add several records. The whole batch goes to one deque when it fits.
+    void produceBatch(const SalesRecord *records, size_t count) override {
+        if (count == 0) {
+            return;
+        }
+        ThreadLane &state = self(false);
+        size_t start = routeByStore ? static_cast<size_t>(records[0].storeID) % lanes.size() : state.cursor++ % lanes.size();
+        WaitTimer timer;
+        size_t done = 0;
+        while (done < count) {
+            size_t n = pushSome(records + done, count - done, start);
+            done += n;
+            if (n > 0) {
+                notEmpty.wakeAll(); // Any consumer may take these (its own deque or by stealing).
+                continue;
+            }
+            timer.begin(); // Every deque is full.
+            size_t limit = laneCapacity * lanes.size();
+            notFull.park([&]() { return total.load() < limit; });
+        }
+        noteOperation(count, 0);
+    }
+
+    // Consumer function to retrieve up to 'max' records; returns 0 once terminated and every deque is empty.
+    size_t consumeBatch(SalesRecord *out, size_t max, std::atomic<bool> &terminate) override {
+        if (max == 0) {
+            return 0;
+        }
+        size_t own = self(true).lane;
+        WaitTimer timer;
+        for (int pass = 0;; ++pass) {
+            size_t stolen = 0;
+            size_t n = popSome(out, max, own, stolen);
+            if (n > 0) {
+                noteOperation(n, stolen);
+                if (n == 1) {
+                    notFull.wakeOne();
+                } else {
+                    notFull.wakeAll();
+                }
+                return n;
+            }
+            if (terminate.load(std::memory_order_acquire) && total.load() == 0) {
+                return 0; // Terminated and nothing left anywhere.
+            }
+            timer.begin();
+            if (pass < SPIN_LIMIT) {
+                cpuRelax();
+                continue;
+            }
+            notEmpty.park([&]() { return total.load() > 0 || terminate.load(std::memory_order_acquire); });
+        }
+    }
+
+    // Function to check if the buffer is empty.
+    bool isEmpty() override {
+        return total.load() == 0;
+    }
+
+    size_t size() override { return total.load(); }
+
+    size_t capacity() const override { return lanes.size() * laneCapacity; }
+
+    // Function to notify all waiting consumers that production is complete.
+    void notifyAllDone() override {
+        std::lock_guard<std::mutex> lock(notEmpty.mtx); // Unconditional: consumers may be between their check and park.
+        notEmpty.cv.notify_all();
+    }
+};
+
+// Buffer implementations that runSimulation can choose between at runtime.
+enum class BufferBackend {
+    Mutex,        // SharedBuffer: std::queue + mutex + condition variables.
+    LockFree,     // LockFreeBuffer: bounded MPMC ring with per-slot sequence numbers.
+    WorkStealing  // WorkStealingBuffer: one deque per consumer, idle consumers steal.
+};
+
+// Human-readable backend name used in logs and on the command line.
+const char *backendName(BufferBackend backend) {
+    switch (backend) {
+    case BufferBackend::LockFree:
+        return "lockfree";
+    case BufferBackend::WorkStealing:
+        return "stealing";
+    default:
+        return "mutex";
+    }
+}
+
+// Create the buffer for the selected backend. 'consumers' sizes the work-stealing topology,
+// where 'size' is the capacity of each consumer's deque rather than of one shared queue.
+std::unique_ptr<RecordBuffer> makeBuffer(BufferBackend backend, size_t size, int consumers, bool routeByStore) {
+    if (backend == BufferBackend::LockFree) {
+        return std::make_unique<LockFreeBuffer>(size);
+    }
+    if (backend == BufferBackend::WorkStealing) {
+        return std::make_unique<WorkStealingBuffer>(size, consumers, routeByStore);
+    }
+    return std::make_unique<SharedBuffer>(size);
+}
+
+// Tunables for a single simulation run.
+struct SimulationOptions {
+    BufferBackend backend = BufferBackend::Mutex; // Which buffer implementation to use.
+    bool routeByStore = false;                    // Work-stealing backend: route records by storeID instead of round-robin.
+    size_t batchSize = 1;                         // Records moved per produceBatch/consumeBatch call (1 = one at a time).
+    std::chrono::milliseconds flushTimeout{50};   // Longest a producer holds a partial batch before flushing it.
+    uint64_t seed = 0;                            // Base seed for every thread's RNG stream (same seed = same records).
+    long long records = 0;                        // Total records across all producers (0 = 1000 per producer, as in the assignment).
+    bool simulateSleep = true;                    // Sleep 5-40 ms per record on both sides, as in the assignment.
+    unsigned busyWork = 0;                        // Without sleeps: iterations of busy work per record (0 = none).
+    bool measureLatency = false;                  // Stamp records and collect enqueue-to-dequeue latency.
+    bool verbose = true;                          // Log progress, per-consumer totals and global statistics.
+    bool console = true;                          // Also echo that log to std::cout (off for concurrent sweep runs).
+    bool instrument = true;                       // Collect BufferCounters on every producer and consumer thread.
+    const PackedSalesRecord *replayRecords = nullptr; // Records to replay from a mapped sales log (null = generate).
+    uint64_t replayCount = 0;                     // Number of records in replayRecords.
+    std::string recordLogPath;                    // If set, consumers write every consumed record to this sales log.
+    std::chrono::milliseconds snapshotInterval{0}; // Report running totals this often while the run is in progress (0 = off).
+    int firstYear = 16;                           // Generated records are dated in years firstYear..firstYear+years-1.
+    int years = 1;
+};
+
+// Log-linear latency histogram (HDR-style): 16 sub-buckets per power of two, so any
+// percentile is reported within ~6% while recording stays one increment.
+struct LatencyHistogram {
+    static constexpr int SUB_BITS = 4;                          // log2 of sub-buckets per power of two.
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+    std::vector<uint64_t> counts = std::vector<uint64_t>(BUCKETS, 0); // Samples per bucket.
+    uint64_t samples = 0;                                       // Total samples recorded.
+
+    // Bucket index for a value in nanoseconds.
+    static int bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<int>(value); // Small values are exact.
+        }
+        int exponent = 63 - __builtin_clzll(value); // Position of the highest set bit (>= SUB_BITS).
+        int sub = static_cast<int>((value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1));
+        return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+    }
+
+    // Smallest value that falls into a bucket (used when reporting).
+    static uint64_t bucketFloor(int bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return static_cast<uint64_t>(bucket);
+        }
+        int exponent = bucket / SUB_BUCKETS + SUB_BITS - 1;
+        uint64_t sub = static_cast<uint64_t>(bucket % SUB_BUCKETS);
+        return (static_cast<uint64_t>(SUB_BUCKETS) + sub) << (exponent - SUB_BITS);
+    }
+
+    void record(int64_t nanos) {
+        counts[bucketOf(nanos > 0 ? static_cast<uint64_t>(nanos) : 0)]++;
+        samples++;
+    }
+
+    void merge(const LatencyHistogram &other) {
+        for (int i = 0; i < BUCKETS; ++i) {
+            counts[i] += other.counts[i];
+        }
+        samples += other.samples;
+    }
+
+    // Value at quantile q (0..1), in nanoseconds; 0 when nothing was recorded.
+    uint64_t percentile(double q) const {
+        if (samples == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(samples - 1)) + 1; // 1-based rank of the sample.
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return bucketFloor(i);
+            }
+        }
+        return bucketFloor(BUCKETS - 1);
+    }
+};
+
+// Buffer instrumentation merged from every thread at the end of a run.
+struct BufferReport {
+    BufferCounters producers; // Sum over producer threads.
+    BufferCounters consumers; // Sum over consumer threads.
+    std::vector<std::pair<std::string, uint64_t>> threadRecords; // Records handled per thread ("Producer 3", 1000).
+
+    // Share of the producers' (or consumers') combined thread time spent blocked on the buffer.
+    static double blockedShare(const BufferCounters &side, int threads, double seconds) {
+        return threads > 0 && seconds > 0 ? side.waitNanos / (threads * seconds * 1e9) : 0;
+    }
+
+    // Share of lock (or claim) attempts that lost to another thread.
+    double contention() const {
+        uint64_t attempts = producers.lockAttempts + consumers.lockAttempts;
+        return attempts > 0 ? static_cast<double>(producers.failedTryLocks + consumers.failedTryLocks) / attempts : 0;
+    }
+
+    // Which side limits throughput: whoever makes the other side wait, unless threads mostly fight over the lock.
+    std::string verdict(int p, int c, double seconds) const {
+        double producersBlocked = blockedShare(producers, p, seconds);
+        double consumersBlocked = blockedShare(consumers, c, seconds);
+        if (contention() >= 0.2 && producersBlocked < 0.5 && consumersBlocked < 0.5) {
+            return "lock-bound";
+        }
+        if (producersBlocked < 0.05 && consumersBlocked < 0.05) {
+            return "balanced";
+        }
+        return producersBlocked >= consumersBlocked ? "consumer-bound" : "producer-bound";
+    }
+
+    // Write the human-readable report for a run.
+    void print(std::ostream &out, int p, int c, double seconds) const {
+        double producersBlocked = blockedShare(producers, p, seconds);
+        double consumersBlocked = blockedShare(consumers, c, seconds);
+        uint64_t failed = producers.failedTryLocks + consumers.failedTryLocks;
+        uint64_t attempts = producers.lockAttempts + consumers.lockAttempts;
+        out << "Buffer instrumentation:\n" << std::fixed << std::setprecision(2);
+        out << "  Producers blocked on full buffer: " << producers.waitNanos / 1e9 << " s over " << producers.waits
+            << " waits (" << producersBlocked * 100 << "% of producer time)\n";
+        out << "  Consumers blocked on empty buffer: " << consumers.waitNanos / 1e9 << " s over " << consumers.waits
+            << " waits (" << consumersBlocked * 100 << "% of consumer time)\n";
+        out << "  Contention: " << failed << " of " << attempts << " lock attempts failed (" << contention() * 100 << "%)\n";
+        if (consumers.steals > 0) {
+            out << "  Stolen records: " << consumers.steals << " (" << (consumers.records ? 100.0 * consumers.steals / consumers.records : 0.0)
+                << "% of consumed)\n";
+        }
+        BufferCounters all = producers;
+        all.merge(consumers);
+        uint64_t samples = 0;
+        for (uint64_t count : all.occupancy) {
+            samples += count;
+        }
+        out << "  Occupancy:";
+        for (int i = 0; i < BufferCounters::OCCUPANCY_BUCKETS; ++i) {
+            out << " " << i * 10 << "%=" << (samples ? 100.0 * all.occupancy[i] / samples : 0.0) << "%";
+        }
+        out << "\n  Records per thread:";
+        for (const auto &[name, records] : threadRecords) {
+            out << " " << name << "=" << records;
+        }
+        out << "\n  Verdict: " << verdict(p, c, seconds) << "\n";
+    }
+};
+
+// What one runSimulation call measured.
+struct SimulationResult {
+    double seconds = 0;        // Wall time from launching the first thread to joining the last one.
+    long long records = 0;     // Records consumed.
+    LatencyHistogram latency;  // Enqueue-to-dequeue latency (empty unless options.measureLatency).
+    BufferReport buffer;       // Buffer instrumentation (empty unless options.instrument).
+};
+
+// Kahan-compensated running sum: keeps long runs of small float amounts from drifting.
+struct KahanSum {
+    double sum = 0;          // Running total.
+    double compensation = 0; // Low-order bits lost by the previous addition.
+
+    void add(double value) {
+        double y = value - compensation;
+        double t = sum + y;
+        compensation = (t - sum) - y; // Recover what was rounded away.
+        sum = t;
+    }
+
+    void add(const KahanSum &other) {
+        add(other.sum);
+        add(-other.compensation);
+    }
+
+    double value() const { return sum - compensation; } // Total with the pending correction applied.
+};
+
+// Sales statistics for one consumer (or the merged global totals).
+// Store and month totals are flat arrays indexed directly by storeID and month, so an update is
+// two array writes instead of two hash lookups. Each consumer owns its own instance, aligned to
+// a cache line so neighbouring consumers never write to the same line.
+// Store IDs outside 0..DENSE_STORES-1 (negative, or very large ones from a sales log) fall back to
+// an ordered map, and year-month totals keep one row per year from the earliest year seen, so
+// neither the number of stores nor the time range is fixed in advance.
+struct alignas(CACHE_LINE) SalesStats {
+    static constexpr int DENSE_STORES = 1 << 16; // Store IDs below this use the flat arrays.
+
+    KahanSum total;                           // Aggregate sales (all sales together).
+    long long records = 0;                    // Number of records counted.
+    std::array<KahanSum, 13> monthSales{};    // Month-wise totals, index 1..12 (index 0 unused).
+    std::array<long long, 13> monthCounts{};  // Records per month, used to print only months that were seen.
+    std::vector<KahanSum> storeSales;         // Store-wise totals, indexed by storeID (grown on demand).
+    std::vector<long long> storeCounts;       // Records per store, used to print only stores that were seen.
+    std::map<int, std::pair<KahanSum, long long>> otherStores; // Totals and counts for IDs outside the flat arrays.
+    int firstYear = 0;                                  // Year of periodSales[0].
+    std::vector<std::array<KahanSum, 12>> periodSales;  // Year-month totals, one row per year from firstYear.
+    std::vector<std::array<long long, 12>> periodCounts; // Records per year-month.
+
+    // Row of periodSales for 'year', growing the table at either end if needed.
+    size_t yearRow(int year) {
+        if (periodSales.empty()) {
+            firstYear = year;
+        } else if (year < firstYear) { // Earlier than anything seen so far: prepend rows.
+            size_t grow = static_cast<size_t>(firstYear - year);
+            periodSales.insert(periodSales.begin(), grow, std::array<KahanSum, 12>{});
+            periodCounts.insert(periodCounts.begin(), grow, std::array<long long, 12>{});
+            firstYear = year;
+        }
+        size_t row = static_cast<size_t>(year - firstYear);
+        if (row >= periodSales.size()) {
+            periodSales.resize(row + 1);
+            periodCounts.resize(row + 1);
+        }
+        return row;
+    }
+
+    // Add one sales record.
+    void add(const SalesRecord &record) {
+        total.add(record.saleAmount);
+        records++;
+        if (record.storeID >= 0 && record.storeID < DENSE_STORES) {
+            size_t store = static_cast<size_t>(record.storeID);
+            if (store >= storeSales.size()) { // First record from a store we have not seen yet.
+                storeSales.resize(store + 1);
+                storeCounts.resize(store + 1, 0);
+            }
+            storeSales[store].add(record.saleAmount);
+            storeCounts[store]++;
+        } else {
+            auto &entry = otherStores[record.storeID];
+            entry.first.add(record.saleAmount);
+            entry.second++;
+        }
+        size_t month = record.month >= 1 && record.month <= 12 ? record.month : 0; // Bad months (e.g. from a corrupt log) go to slot 0.
+        monthSales[month].add(record.saleAmount);
+        monthCounts[month]++;
+        if (month != 0) {
+            size_t row = yearRow(record.year);
+            periodSales[row][month - 1].add(record.saleAmount);
+            periodCounts[row][month - 1]++;
+        }
+    }
+
+    // Call fn(storeID, total) for every store that reported sales, in ascending storeID order.
+    template <typename Fn>
+    void forEachStore(Fn fn) const {
+        auto other = otherStores.begin();
+        for (; other != otherStores.end() && other->first < 0; ++other) {
+            fn(other->first, other->second.first);
+        }
+        for (size_t storeID = 0; storeID < storeSales.size(); ++storeID) {
+            if (storeCounts[storeID] > 0) {
+                fn(static_cast<int>(storeID), storeSales[storeID]);
+            }
+        }
+        for (; other != otherStores.end(); ++other) {
+            fn(other->first, other->second.first);
+        }
+    }
+
+    // Fold another set of statistics into this one.
+    void merge(const SalesStats &other) {
+        if (other.storeSales.size() > storeSales.size()) {
+            storeSales.resize(other.storeSales.size());
+            storeCounts.resize(other.storeCounts.size(), 0);
+        }
+        total.add(other.total);
+        records += other.records;
+        for (size_t i = 0; i < other.storeSales.size(); ++i) {
+            storeSales[i].add(other.storeSales[i]);
+            storeCounts[i] += other.storeCounts[i];
+        }
+        for (size_t m = 0; m < monthSales.size(); ++m) {
+            monthSales[m].add(other.monthSales[m]);
+            monthCounts[m] += other.monthCounts[m];
+        }
+        for (const auto &entry : other.otherStores) {
+            auto &mine = otherStores[entry.first];
+            mine.first.add(entry.second.first);
+            mine.second += entry.second.second;
+        }
+        for (size_t r = 0; r < other.periodSales.size(); ++r) {
+            size_t row = yearRow(other.firstYear + static_cast<int>(r));
+            for (size_t m = 0; m < 12; ++m) {
+                periodSales[row][m].add(other.periodSales[r][m]);
+                periodCounts[row][m] += other.periodCounts[r][m];
+            }
+        }
+    }
+};
+
+// SplitMix64 step: turns a simple counter/seed into well-mixed 64-bit values (used for seeding).
+inline uint64_t splitMix64(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Per-thread xoshiro256** generator, run as LANES independent streams side by side.
+// The state is stored lane-major (s[word][lane]) so nextBlock() is a straight loop over lanes
+// that the compiler can turn into SIMD. Scalar draws (next()) hand out the same block values
+// one at a time, so the stream a seed produces does not depend on how it is consumed.
+class RecordRng {
+public:
+    static constexpr int LANES = 4; // Independent streams advanced together.
+
+private:
+    uint64_t s[4][LANES];     // xoshiro256 state words for every lane.
+    uint64_t cache[LANES];    // Current block for scalar draws.
+    int cachePos = LANES;     // Next unused value in 'cache' (LANES = empty).
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    // Seed every lane from (seed, stream) so each thread can have its own reproducible stream.
+    RecordRng(uint64_t seed, uint64_t stream) {
+        uint64_t sm = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+        for (int word = 0; word < 4; ++word) {
+            for (int lane = 0; lane < LANES; ++lane) {
+                s[word][lane] = splitMix64(sm);
+            }
+        }
+    }
+
+    // Advance all lanes once and write one value per lane.
+    void nextBlock(uint64_t out[LANES]) {
+        for (int lane = 0; lane < LANES; ++lane) {
+            out[lane] = rotl(s[1][lane] * 5, 7) * 9;
+            uint64_t t = s[1][lane] << 17;
+            s[2][lane] ^= s[0][lane];
+            s[3][lane] ^= s[1][lane];
+            s[1][lane] ^= s[2][lane];
+            s[0][lane] ^= s[3][lane];
+            s[2][lane] ^= t;
+            s[3][lane] = rotl(s[3][lane], 45);
+        }
+    }
+
+    // Next 64-bit value of the stream.
+    uint64_t next() {
+        if (cachePos == LANES) {
+            nextBlock(cache);
+            cachePos = 0;
+        }
+        return cache[cachePos++];
+    }
+
+    // True when the next value starts a fresh block (bulk generation can then use whole blocks).
+    bool atBlockBoundary() const { return cachePos == LANES; }
+
+    // Uniform integer in [0, range) using a multiply-shift instead of a division.
+    uint32_t below(uint32_t range) {
+        return static_cast<uint32_t>(((next() >> 32) * range) >> 32);
+    }
+};
+
+// Fill one record for 'storeID' from 64 random bits, without branches or divisions:
+// bits 0-15 pick the day, 16-31 the month, 32-39 the register and 40-63 the amount.
+inline void fillRecord(SalesRecord &record, int storeID, uint64_t bits, int firstYear, int years) {
+    uint32_t dayProduct = static_cast<uint32_t>(bits & 0xFFFF) * 30;
+    record.day = 1 + static_cast<int>(dayProduct >> 16);                       // Random day (1-30).
+    record.month = 1 + static_cast<int>((((bits >> 16) & 0xFFFF) * 12) >> 16); // Random month (1-12).
+    record.year = firstYear;                                                   // Fixed year (16 in the assignment)...
+    if (years > 1) { // ...or one of 'years' years, drawn from the fraction the day reduction left over.
+        record.year += static_cast<int>(((dayProduct & 0xFFFF) * static_cast<uint64_t>(years)) >> 16);
+    }
+    record.storeID = storeID;                                                  // Store ID assigned to the producer.
+    record.registerNum = 1 + static_cast<int>((((bits >> 32) & 0xFF) * 6) >> 8); // Random register number (1-6).
+    record.saleAmount = 0.50f + static_cast<float>(bits >> 40) * ((999.99f - 0.50f) / 16777216.0f); // Random sale amount (0.50-999.99).
+}
+
+// Function to generate a random sales record for a given store ID, dated in years firstYear..firstYear+years-1.
+SalesRecord generateRecord(int storeID, RecordRng &rng, int firstYear = 16, int years = 1) {
+    SalesRecord record;
+    fillRecord(record, storeID, rng.next(), firstYear, years);
+    return record; // Return the generated sales record.
+}
+
+// Generate 'count' records for a store at once. Whole RNG blocks are used where possible so the
+// inner loop is branch-free and vectorizable; the result is the same as calling generateRecord 'count' times.
+void generateRecords(int storeID, SalesRecord *out, size_t count, RecordRng &rng, int firstYear = 16, int years = 1) {
+    size_t i = 0;
+    while (i < count && !rng.atBlockBoundary()) { // Use up a partially consumed block first.
+        fillRecord(out[i++], storeID, rng.next(), firstYear, years);
+    }
+    uint64_t bits[RecordRng::LANES];
+    for (; i + RecordRng::LANES <= count; i += RecordRng::LANES) {
+        rng.nextBlock(bits);
+        for (int lane = 0; lane < RecordRng::LANES; ++lane) {
+            fillRecord(out[i + lane], storeID, bits[lane], firstYear, years);
+        }
+    }
+    for (; i < count; ++i) { // Leftover records.
+        fillRecord(out[i], storeID, rng.next(), firstYear, years);
+    }
+}
+
+// Offset that separates a thread's delay stream from its record stream (and consumers from producers).
+constexpr uint64_t DELAY_STREAM = 1ULL << 32;
+constexpr uint64_t CONSUMER_STREAM = 1ULL << 33;
+
+// A file mapped into memory: read-only for replay/aggregation, read-write for recording.
+// On platforms without mmap the file is read into (or written from) an ordinary buffer instead.
+class MappedFile {
 private:
-    std::queue<SalesRecord> buffer;          // The buffer implemented as a queue to store records.
-    size_t maxSize;                          // The maximum number of items the buffer can hold.
-    std::mutex mtx;                          // Mutex to ensure thread-safe access to the buffer.
-    std::condition_variable cvFull, cvEmpty; // Condition variables for producer-consumer synchronization.
+    uint8_t *bytes = nullptr; // Start of the mapping.
+    size_t length = 0;        // Mapped size in bytes.
+    bool writable = false;    // Whether the file was created for writing.
+#ifdef _WIN32
+    std::vector<uint8_t> storage; // Fallback buffer.
+    std::string filePath;         // Where to write 'storage' back on close.
+#else
+    int fd = -1;                  // Open file descriptor.
+#endif
 
 public:
-    // Constructor to initialize the buffer with a given size.
-    SharedBuffer(size_t size) : maxSize(size) {}
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() { close(length); }
 
-    // Producer function to add a record to the buffer.
-    void produce(const SalesRecord &record) {
-        std::unique_lock<std::mutex> lock(mtx); // Lock the mutex to access the buffer.
-        cvFull.wait(lock, [this]() { return buffer.size() < maxSize; }); // Wait if the buffer is full.
-        buffer.push(record); // Add the sales record to the buffer.
-        cvEmpty.notify_one(); // Notify one waiting consumer that a new item is available.
+    uint8_t *data() const { return bytes; }
+    size_t size() const { return length; }
+
+    // Map an existing file read-only. Returns false if it cannot be opened or mapped.
+    bool openRead(const std::string &path) {
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        storage.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        bytes = storage.data();
+        length = storage.size();
+        return true;
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(0);
+            return false;
+        }
+        length = static_cast<size_t>(info.st_size);
+        void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            length = 0;
+            close(0);
+            return false;
+        }
+        bytes = static_cast<uint8_t *>(mapping);
+        madvise(mapping, length, MADV_SEQUENTIAL); // Records are read front to back.
+        return true;
+#endif
     }
 
-    // Consumer function to retrieve a record from the buffer.
-    SalesRecord consume(bool &terminate) {
-        std::unique_lock<std::mutex> lock(mtx); // Lock the mutex to access the buffer.
-        cvEmpty.wait(lock, [this, &terminate]() { return !buffer.empty() || terminate; }); // Wait if the buffer is empty.
+    // Create (or truncate) a file of 'size' bytes and map it read-write.
+    bool create(const std::string &path, size_t size) {
+        writable = true;
+#ifdef _WIN32
+        storage.assign(size, 0);
+        bytes = storage.data();
+        length = size;
+        filePath = path;
+        return true;
+#else
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(0);
+            return false;
+        }
+        length = size;
+        void *mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            length = 0;
+            close(0);
+            return false;
+        }
+        bytes = static_cast<uint8_t *>(mapping);
+        return true;
+#endif
+    }
 
-        if (terminate && buffer.empty()) {
-            return {}; // Return an empty record if no more items are available and termination is signaled.
+    // Unmap the file. A writable file is cut down to 'finalSize' bytes.
+    void close(size_t finalSize) {
+#ifdef _WIN32
+        if (writable && bytes) {
+            std::ofstream out(filePath, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(storage.data()), static_cast<std::streamsize>(std::min(finalSize, storage.size())));
+        }
+        storage.clear();
+#else
+        if (bytes) {
+            munmap(bytes, length);
+        }
+        if (fd >= 0) {
+            if (writable && finalSize < length) {
+                if (ftruncate(fd, static_cast<off_t>(finalSize)) != 0) {
+                    std::cerr << "Warning: could not trim mapped file.\n";
+                }
+            }
+            ::close(fd);
+        }
+        fd = -1;
+#endif
+        bytes = nullptr;
+        length = 0;
+        writable = false;
+    }
+};
+
+// Read side of a binary sales log: records are used in place from the mapped pages.
+class SalesLogReader {
+private:
+    MappedFile file;
+    const PackedSalesRecord *first = nullptr; // First record in the mapping.
+    uint64_t count = 0;                       // Number of records.
+
+public:
+    // Map and validate a log. On failure 'error' says why.
+    bool open(const std::string &path, std::string &error) {
+        if (!file.openRead(path)) {
+            error = "could not open or map " + path;
+            return false;
+        }
+        if (file.size() < sizeof(SalesLogHeader)) {
+            error = path + " is too small to be a sales log";
+            return false;
         }
+        SalesLogHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, SALES_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != SALES_LOG_VERSION || header.recordSize != sizeof(PackedSalesRecord)) {
+            error = path + " is not a version " + std::to_string(SALES_LOG_VERSION) + " sales log";
+            return false;
+        }
+        uint64_t available = (file.size() - sizeof(SalesLogHeader)) / sizeof(PackedSalesRecord);
+        count = std::min(header.recordCount, available); // Never trust the header past the end of the file.
+        first = reinterpret_cast<const PackedSalesRecord *>(file.data() + sizeof(SalesLogHeader));
+        return true;
+    }
 
-        SalesRecord record = buffer.front(); // Get the front record in the buffer.
-        buffer.pop(); // Remove the record from the buffer.
-        cvFull.notify_one(); // Notify one waiting producer that space is now available.
-        return record;
+    const PackedSalesRecord *records() const { return first; }
+    uint64_t size() const { return count; }
+};
+
+// Write side of a binary sales log. The file is sized for 'capacity' records up front; writers
+// reserve a range with one atomic add and pack records straight into the mapped pages.
+class SalesLogWriter {
+private:
+    MappedFile file;
+    PackedSalesRecord *first = nullptr;   // First record slot in the mapping.
+    uint64_t capacity = 0;                // Record slots available.
+    std::atomic<uint64_t> next{0};        // Next free slot.
+
+public:
+    bool open(const std::string &path, uint64_t records) {
+        capacity = records;
+        if (!file.create(path, sizeof(SalesLogHeader) + records * sizeof(PackedSalesRecord))) {
+            return false;
+        }
+        first = reinterpret_cast<PackedSalesRecord *>(file.data() + sizeof(SalesLogHeader));
+        return true;
     }
 
-    // Function to check if the buffer is empty.
-    bool isEmpty() {
-        std::lock_guard<std::mutex> lock(mtx); // Lock the mutex for thread-safe access.
-        return buffer.empty(); // Return true if the buffer is empty.
+    // Append 'count' records (thread-safe). Records beyond the capacity are dropped.
+    void append(const SalesRecord *records, size_t count) {
+        uint64_t start = next.fetch_add(count, std::memory_order_relaxed);
+        uint64_t end = std::min<uint64_t>(start + count, capacity);
+        for (uint64_t slot = start; slot < end; ++slot) {
+            first[slot] = packRecord(records[slot - start]);
+        }
     }
 
-    // Function to notify all waiting consumers that production is complete.
-    void notifyAllDone() {
-        std::unique_lock<std::mutex> lock(mtx); // Lock the mutex.
-        cvEmpty.notify_all(); // Notify all consumers waiting on cvEmpty.
+    // Direct access for bulk writers that fill the log themselves.
+    PackedSalesRecord *records() { return first; }
+
+    // Write the header and unmap. Returns the number of records in the log.
+    uint64_t close(uint64_t written) {
+        if (!file.data()) {
+            return 0;
+        }
+        written = std::min(written, capacity);
+        SalesLogHeader header{};
+        std::memcpy(header.magic, SALES_LOG_MAGIC, sizeof(header.magic));
+        header.version = SALES_LOG_VERSION;
+        header.recordSize = sizeof(PackedSalesRecord);
+        header.recordCount = written;
+        std::memcpy(file.data(), &header, sizeof(header));
+        file.close(sizeof(SalesLogHeader) + written * sizeof(PackedSalesRecord));
+        return written;
     }
+
+    uint64_t close() { return close(next.load()); }
 };
 
-// Global variables shared between threads.
-std::atomic<int> totalRecords(0);    // Atomic variable to count the total number of produced records.
-std::atomic<bool> done(false);      // Atomic flag to signal that all producers are finished.
-std::mutex statsMtx;                // Mutex to protect access to shared statistics.
-float globalSales = 0;              // Total sales across all stores and months.
-std::unordered_map<int, float> storeSales; // Store-wise sales statistics.
-std::unordered_map<int, float> monthSales; // Month-wise sales statistics.
-
-// Function to generate a random sales record for a given store ID.
-SalesRecord generateRecord(int storeID) {
-    static std::mt19937 rng(std::random_device{}()); // Random number generator.
-    std::uniform_int_distribution<int> dayDist(1, 30); // Random day (1-30).
-    std::uniform_int_distribution<int> monthDist(1, 12); // Random month (1-12).
-    std::uniform_int_distribution<int> regDist(1, 6); // Random register number (1-6).
-    std::uniform_real_distribution<float> amountDist(0.50, 999.99); // Random sale amount (0.50-999.99).
+// A consumer's most recently published statistics, copied out by the snapshot reporter.
+// The consumer only ever try-locks the slot, so a reporter that is busy copying never stalls it.
+struct alignas(CACHE_LINE) PublishedStats {
+    static constexpr uint64_t FINAL = ~0ULL; // Epoch of a slot whose consumer has exited.
+    std::mutex mtx;                 // Held while the consumer publishes or the reporter copies.
+    SalesStats stats;               // Copy of the consumer's local statistics.
+    std::atomic<uint64_t> epoch{0}; // Snapshot epoch this copy answers.
+};
 
-    SalesRecord record;
-    record.day = dayDist(rng); // Generate random day.
-    record.month = monthDist(rng); // Generate random month.
-    record.year = 16; // Fixed year.
-    record.storeID = storeID; // Store ID assigned to the producer.
-    record.registerNum = regDist(rng); // Generate random register number.
-    record.saleAmount = amountDist(rng); // Generate random sale amount.
+// Variables shared between the threads of one simulation run. Every runSimulation call owns its
+// own context, so independent runs can execute side by side (see runSweep).
+struct SimulationContext {
+    std::atomic<long long> totalRecords{0}; // Atomic variable to count the total number of produced records.
+    std::atomic<bool> done{false};          // Atomic flag to signal that all producers are finished.
+    std::atomic<bool> terminate{false};     // Flag to indicate when consumers should terminate.
+    std::mutex statsMtx;                    // Mutex to protect access to the merged statistics below.
+    SalesStats stats;                       // Store-wise, month-wise and aggregate sales (merged from consumers at shutdown).
+    LatencyHistogram latency;               // Enqueue-to-dequeue latency merged from consumers at shutdown.
+    BufferReport report;                    // Buffer counters merged from producers and consumers at shutdown.
+    SalesLogWriter *sink = nullptr;         // If set, consumers write every consumed record to this sales log.
+    std::unique_ptr<PublishedStats[]> published; // One slot per consumer (only allocated when snapshots are on).
+    std::atomic<uint64_t> snapshotEpoch{0};      // Bumped by the reporter to ask consumers to publish.
+    std::mutex reporterMtx;                      // Protects reporterStop.
+    std::condition_variable reporterWake;        // Wakes the reporter early when the run ends.
+    bool reporterStop = false;                   // Set once every consumer has finished.
+};
 
-    return record; // Return the generated sales record.
+// Copy 'local' into consumer 'id's snapshot slot and tag it with 'epoch'. Unless 'wait' is set,
+// give up if the reporter is copying the slot right now; the consumer retries after its next batch.
+inline bool publishStats(SimulationContext &ctx, int id, const SalesStats &local, uint64_t epoch, bool wait = false) {
+    PublishedStats &slot = ctx.published[id - 1];
+    std::unique_lock<std::mutex> lock(slot.mtx, std::defer_lock);
+    if (wait) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return false;
+    }
+    slot.stats = local;
+    slot.epoch.store(epoch, std::memory_order_release);
+    return true;
+}
+
+// Stand-in for per-record work when sleeps are disabled; the barrier keeps the loop from being optimized away.
+inline void busyWork(unsigned iterations) {
+    for (unsigned i = 0; i < iterations; ++i) {
+#if defined(__GNUC__)
+        __asm__ __volatile__("" ::: "memory");
+#else
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
 }
 
 // Function executed by each producer thread.
-void producer(SharedBuffer &buffer, int storeID, int maxRecords) {
-    for (int i = 0; i < maxRecords; ++i) { // Each producer generates a fixed number of records.
-        SalesRecord record = generateRecord(storeID); // Generate a sales record for the assigned store.
-        buffer.produce(record); // Add the record to the shared buffer.
+// Records are handed to the buffer in batches of up to options.batchSize. A partial batch is
+// flushed early if holding it through the next simulated delay would exceed options.flushTimeout.
+// Records for a batch are generated in bulk up front (or unpacked from 'source' when replaying a
+// sales log) and then released one simulated delay at a time.
+void producer(SimulationContext &ctx, RecordBuffer &buffer, int storeID, long long maxRecords, const PackedSalesRecord *source, const SimulationOptions &options) {
+    RecordRng recordRng(options.seed, static_cast<uint64_t>(storeID));              // This producer's record stream.
+    RecordRng delayRng(options.seed, DELAY_STREAM + static_cast<uint64_t>(storeID)); // This producer's sleep stream.
+    std::vector<SalesRecord> chunk(options.batchSize); // Records generated for the current batch.
+    size_t chunkSize = 0;  // Records in 'chunk'.
+    size_t emitted = 0;    // Records of 'chunk' whose simulated production has happened.
+    size_t flushed = 0;    // Records of 'chunk' already handed to the buffer.
+    auto batchStart = std::chrono::steady_clock::now(); // When the oldest unflushed record was produced.
+    BufferCounters counters; // This thread's buffer instrumentation.
+    threadCounters = options.instrument ? &counters : nullptr;
 
-        {
-            std::lock_guard<std::mutex> lock(statsMtx); // Lock the mutex to safely update the total record count.
-            totalRecords++; // Increment the global record count.
+    for (long long i = 0; i < maxRecords; ++i) { // Each producer generates a fixed number of records.
+        if (emitted == chunkSize) { // Generate the next batch of sales records for the assigned store.
+            chunkSize = static_cast<size_t>(std::min(static_cast<long long>(options.batchSize), maxRecords - i));
+            if (source) {
+                for (size_t k = 0; k < chunkSize; ++k) {
+                    chunk[k] = unpackRecord(source[i + static_cast<long long>(k)]);
+                }
+            } else {
+                generateRecords(storeID, chunk.data(), chunkSize, recordRng, options.firstYear, options.years);
+            }
+            emitted = flushed = 0;
+        }
+        if (emitted == flushed && options.batchSize > 1) {
+            batchStart = std::chrono::steady_clock::now();
+        }
+        emitted++;
+
+        std::chrono::milliseconds delay(0);
+        if (options.simulateSleep) {
+            delay = std::chrono::milliseconds(5 + delayRng.below(36)); // Simulated processing time (5–40 ms).
+        }
+        bool flush = emitted == chunkSize || // Batch full (also true for the last record).
+                     std::chrono::steady_clock::now() + delay - batchStart >= options.flushTimeout; // Holding it any longer would exceed the timeout.
+        if (flush) {
+            size_t count = emitted - flushed;
+            if (options.measureLatency) {
+                int64_t stamp = nowNanos(); // One clock read per batch.
+                for (size_t k = flushed; k < emitted; ++k) {
+                    chunk[k].enqueueTime = stamp;
+                }
+            }
+            buffer.produceBatch(chunk.data() + flushed, count); // Add the batch to the shared buffer.
+            ctx.totalRecords.fetch_add(static_cast<long long>(count)); // Increment the run's record count (atomic, no lock needed).
+            flushed = emitted;
+        }
+
+        if (options.simulateSleep) {
+            std::this_thread::sleep_for(delay); // Simulate processing time.
+        } else {
+            busyWork(options.busyWork);
         }
+    }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(5 + rand() % 36)); // Simulate processing time (5–40 ms).
+    threadCounters = nullptr;
+    if (options.instrument) { // Merge this producer's counters once, at the end.
+        std::lock_guard<std::mutex> lock(ctx.statsMtx);
+        ctx.report.producers.merge(counters);
+        ctx.report.threadRecords.emplace_back("Producer " + std::to_string(storeID), counters.records);
     }
 
-    done = true; // Set the global flag to indicate that all producers have completed their tasks.
+    ctx.done = true; // Set the run's flag to indicate that all producers have completed their tasks.
     buffer.notifyAllDone(); // Notify all consumers that no more records will be produced.
 }
 
 // Function executed by each consumer thread.
-void consumer(SharedBuffer &buffer, int id, std::ofstream &outputFile, bool &terminate) {
-    float localSales = 0; // Local total sales for this consumer.
+// Each consumer accumulates into its own SalesStats and only touches ctx.statsMtx once, when it merges at shutdown.
+// If ctx.sink is set, every consumed record is also written to that sales log.
+void consumer(SimulationContext &ctx, RecordBuffer &buffer, int id, std::ostream &outputFile, const SimulationOptions &options) {
+    SalesStats local; // Local statistics for this consumer.
+    LatencyHistogram latency; // Local enqueue-to-dequeue latency samples.
+    RecordRng delayRng(options.seed, CONSUMER_STREAM + static_cast<uint64_t>(id)); // This consumer's sleep stream.
+    std::vector<SalesRecord> batch(options.batchSize); // Records taken from the buffer in one call.
+    BufferCounters counters; // This thread's buffer instrumentation.
+    threadCounters = options.instrument ? &counters : nullptr;
+    uint64_t publishedEpoch = 0; // Last snapshot epoch this consumer answered.
 
     while (true) {
-        SalesRecord record = buffer.consume(terminate); // Retrieve a record from the buffer.
+        size_t count = buffer.consumeBatch(batch.data(), batch.size(), ctx.terminate); // Retrieve up to batchSize records.
 
-        if (terminate && record.saleAmount == 0) { // Exit if termination is signaled and the buffer is empty.
+        if (count == 0) { // Exit if termination is signaled and the buffer is empty.
             break;
         }
 
-        localSales += record.saleAmount; // Add the sale amount to the consumer's local total.
+        if (ctx.sink) {
+            ctx.sink->append(batch.data(), count); // Pack the batch straight into the mapped log.
+        }
 
-        {
-            std::lock_guard<std::mutex> lock(statsMtx); // Lock the mutex to safely update shared statistics.
-            globalSales += record.saleAmount; // Update the global sales total.
-            storeSales[record.storeID] += record.saleAmount; // Update the store-wise sales total.
-            monthSales[record.month] += record.saleAmount; // Update the month-wise sales total.
+        if (options.measureLatency) {
+            int64_t now = nowNanos(); // One clock read per batch.
+            for (size_t i = 0; i < count; ++i) {
+                latency.record(now - batch[i].enqueueTime);
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            local.add(batch[i]); // Update the consumer's local aggregate, store-wise and month-wise totals.
+            if (options.simulateSleep) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5 + delayRng.below(36))); // Simulate processing time (5–40 ms).
+            } else {
+                busyWork(options.busyWork);
+            }
+        }
+
+        if (ctx.published) { // Snapshots on: answer a new request from the reporter (one relaxed load per batch).
+            uint64_t epoch = ctx.snapshotEpoch.load(std::memory_order_relaxed);
+            if (epoch != publishedEpoch && publishStats(ctx, id, local, epoch)) {
+                publishedEpoch = epoch;
+            }
+        }
+    }
+    if (ctx.published) {
+        publishStats(ctx, id, local, PublishedStats::FINAL, true); // Final totals; the reporter stops waiting on this slot.
+    }
+
+    // Add the local statistics to the run's statistics and log the local sales for this consumer.
+    threadCounters = nullptr;
+    std::lock_guard<std::mutex> lock(ctx.statsMtx);
+        ctx.stats.merge(local);
+        ctx.latency.merge(latency);
+        if (options.instrument) {
+            ctx.report.consumers.merge(counters);
+            ctx.report.threadRecords.emplace_back("Consumer " + std::to_string(id), counters.records);
+        }
+        if (options.verbose) {
+            outputFile << "Consumer " << id << " local sales: " << std::fixed << std::setprecision(2) << local.total.value() << std::endl;
+            if (options.console) {
+                std::cout << "Consumer " << id << " local sales: " << std::fixed << std::setprecision(2) << local.total.value() << std::endl;
+            }
+        }
+}
+
+// Call fn(year, month, total) for every year-month that had sales, in date order.
+template <typename Fn>
+void forEachPeriod(const SalesStats &stats, Fn fn) {
+    for (size_t row = 0; row < stats.periodSales.size(); ++row) {
+        for (size_t m = 0; m < 12; ++m) {
+            if (stats.periodCounts[row][m] > 0) {
+                fn(stats.firstYear + static_cast<int>(row), static_cast<int>(m) + 1, stats.periodSales[row][m]);
+            }
         }
+    }
+}
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(5 + rand() % 36)); // Simulate processing time (5–40 ms).
+// Print aggregate, store-wise and month-wise sales in the results.txt format.
+// Year-month totals are added when the records span more than one year.
+void printSalesStats(std::ostream &out, const SalesStats &stats) {
+    out << "Global sales: " << std::fixed << std::setprecision(2) << stats.total.value() << "\n";
+    out << "Store-wise sales:\n";
+    stats.forEachStore([&](int storeID, const KahanSum &sales) { // Only stores that reported sales.
+        out << "  Store " << storeID << ": " << sales.value() << "\n";
+    });
+    out << "Month-wise sales:\n";
+    for (size_t month = 1; month < stats.monthSales.size(); ++month) {
+        if (stats.monthCounts[month] > 0) { // Only months that had sales.
+            out << "  Month " << month << ": " << stats.monthSales[month].value() << "\n";
+        }
     }
+    if (stats.periodSales.size() > 1) {
+        out << "Period-wise sales (YY/MM):\n";
+        forEachPeriod(stats, [&](int year, int month, const KahanSum &sales) {
+            out << "  Period " << std::setfill('0') << std::setw(2) << year << "/" << std::setw(2) << month
+                << std::setfill(' ') << ": " << sales.value() << "\n";
+        });
+    }
+    out.flush();
+}
+
+// Snapshot reporter thread: every options.snapshotInterval it bumps the snapshot epoch, gives the
+// consumers a short grace period to publish, merges the published copies and logs running
+// store-wise, month-wise and year-month totals with throughput and buffer depth. Consumers never
+// wait for the reporter. A consumer parked on an empty buffer answers after its next batch, so
+// its share of a snapshot can be up to one interval old.
+void snapshotReporter(SimulationContext &ctx, RecordBuffer &buffer, int consumers, std::ostream &outputFile,
+                      const SimulationOptions &options, std::chrono::steady_clock::time_point startTime) {
+    std::chrono::milliseconds grace = std::min(options.snapshotInterval / 4, std::chrono::milliseconds(50));
+    long long lastRecords = 0;
+    auto lastTime = startTime;
+
+    std::unique_lock<std::mutex> lock(ctx.reporterMtx);
+    while (!ctx.reporterWake.wait_for(lock, options.snapshotInterval, [&]() { return ctx.reporterStop; })) {
+        lock.unlock();
+        uint64_t epoch = ctx.snapshotEpoch.fetch_add(1) + 1;
+        auto deadline = std::chrono::steady_clock::now() + grace;
+        for (int i = 0; i < consumers && std::chrono::steady_clock::now() < deadline;) {
+            if (ctx.published[i].epoch.load(std::memory_order_acquire) >= epoch) {
+                ++i; // This consumer has answered (or exited).
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        SalesStats merged;
+        for (int i = 0; i < consumers; ++i) {
+            std::lock_guard<std::mutex> slotLock(ctx.published[i].mtx);
+            merged.merge(ctx.published[i].stats);
+        }
+        size_t depth = buffer.size();
+        auto now = std::chrono::steady_clock::now();
+        std::chrono::duration<double> sinceStart = now - startTime;
+        std::chrono::duration<double> sinceLast = now - lastTime;
+        double rate = sinceLast.count() > 0 ? (merged.records - lastRecords) / sinceLast.count() : 0;
+        double average = sinceStart.count() > 0 ? merged.records / sinceStart.count() : 0;
+        lastRecords = merged.records;
+        lastTime = now;
 
-    // Log the local sales for this consumer to the output file.
-    std::lock_guard<std::mutex> lock(statsMtx);
-        outputFile << "Consumer " << id << " local sales: " << std::fixed << std::setprecision(2) << localSales << std::endl;
-        std::cout << "Consumer " << id << " local sales: " << std::fixed << std::setprecision(2) << localSales << std::endl;
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(3) << "Snapshot at " << sinceStart.count() << " s: " << merged.records
+             << " records, " << std::setprecision(0) << rate << " records/sec (average " << average
+             << "), buffer depth " << depth << "/" << buffer.capacity() << "\n" << std::setprecision(2);
+        text << "  Global sales: " << merged.total.value() << "\n  Stores:";
+        merged.forEachStore([&](int storeID, const KahanSum &sales) { text << " " << storeID << "=" << sales.value(); });
+        text << "\n  Months:";
+        for (size_t month = 1; month < merged.monthSales.size(); ++month) {
+            if (merged.monthCounts[month] > 0) {
+                text << " " << month << "=" << merged.monthSales[month].value();
+            }
+        }
+        text << "\n  Periods:";
+        forEachPeriod(merged, [&](int year, int month, const KahanSum &sales) {
+            text << " " << std::setfill('0') << std::setw(2) << year << "/" << std::setw(2) << month
+                 << std::setfill(' ') << "=" << sales.value();
+        });
+        text << "\n";
+
+        {
+            std::lock_guard<std::mutex> outputLock(ctx.statsMtx); // Consumers log under the same mutex.
+            outputFile << text.str();
+        }
+        if (options.console) {
+            std::cout << text.str();
+        }
+        lock.lock();
+    }
 }
 
-void logMessage(const std::string &message, std::ofstream &outputFile) {
-    std::cout << message << std::endl;
+void logMessage(const std::string &message, std::ostream &outputFile, bool console = true) {
+    if (console) {
+        std::cout << message << std::endl;
+    }
     outputFile << message << std::endl;
 }
 
 // Function to run a single simulation with given parameters (number of producers, consumers, and buffer size).
-void runSimulation(int p, int c, int b, std::ofstream &outputFile) {
-    SharedBuffer buffer(b); // Create the shared buffer with the specified size.
+SimulationResult runSimulation(int p, int c, int b, std::ostream &outputFile, const SimulationOptions &options) {
+    std::unique_ptr<RecordBuffer> bufferPtr = makeBuffer(options.backend, b, c, options.routeByStore); // Create the shared buffer with the selected backend.
+    RecordBuffer &buffer = *bufferPtr;
     std::vector<std::thread> producers, consumers; // Vectors to hold producer and consumer threads.
-    bool terminate = false; // Flag to indicate when consumers should terminate.
+    SimulationContext ctx; // Fresh shared state for this run.
 
-    totalRecords = 0;
-    globalSales = 0;
-    storeSales.clear();
-    monthSales.clear();
-    done = false; // Reset the done flag for each simulation
-
-    logMessage("Starting simulation with p=" + std::to_string(p) +
-               ", c=" + std::to_string(c) + ", b=" + std::to_string(b), outputFile);
+    if (options.verbose) {
+        logMessage("Starting simulation with p=" + std::to_string(p) +
+                   ", c=" + std::to_string(c) + ", b=" + std::to_string(b) +
+                   ", backend=" + backendName(options.backend) +
+                   ", batch=" + std::to_string(options.batchSize) +
+                   ", seed=" + std::to_string(options.seed), outputFile, options.console);
+    }
 
     auto startTime = std::chrono::steady_clock::now(); // Record the simulation start time.
 
+    // Work out how many records each producer handles: 1000 each, an even split of options.records,
+    // or an even split of the replayed log (each producer then reads its own contiguous slice).
+    std::vector<long long> counts(p + 1, 1000);
+    std::vector<const PackedSalesRecord *> sources(p + 1, nullptr);
+    long long plannedRecords = 0;
+    for (int i = 1; i <= p; ++i) {
+        if (options.replayRecords) {
+            uint64_t begin = options.replayCount * (i - 1) / p;
+            uint64_t end = options.replayCount * i / p;
+            counts[i] = static_cast<long long>(end - begin);
+            sources[i] = options.replayRecords + begin;
+        } else if (options.records > 0) {
+            counts[i] = options.records / p + (i <= options.records % p ? 1 : 0);
+        }
+        plannedRecords += counts[i];
+    }
+
+    // Optionally record every consumed record to a binary log sized for this run.
+    std::unique_ptr<SalesLogWriter> sink;
+    if (!options.recordLogPath.empty()) {
+        sink = std::make_unique<SalesLogWriter>();
+        if (!sink->open(options.recordLogPath, static_cast<uint64_t>(plannedRecords))) {
+            std::cerr << "Error: Could not create sales log " << options.recordLogPath << "\n";
+            sink.reset();
+        }
+    }
+    ctx.sink = sink.get();
+    if (options.snapshotInterval.count() > 0) {
+        ctx.published = std::make_unique<PublishedStats[]>(c);
+    }
+
     // Launch producer threads.
-    logMessage("Launching producers...", outputFile);
+    if (options.verbose) {
+        logMessage("Launching producers...", outputFile, options.console);
+    }
     for (int i = 1; i <= p; ++i) {
-        producers.emplace_back(producer, std::ref(buffer), i, 1000); // Each producer generates 1000 records.
+        producers.emplace_back(producer, std::ref(ctx), std::ref(buffer), i, counts[i], sources[i], std::cref(options));
     }
 
     // Launch consumer threads.
-    logMessage("Launching consumers...", outputFile);
+    if (options.verbose) {
+        logMessage("Launching consumers...", outputFile, options.console);
+    }
     for (int i = 1; i <= c; ++i) {
-        consumers.emplace_back(consumer, std::ref(buffer), i, std::ref(outputFile), std::ref(terminate));
+        consumers.emplace_back(consumer, std::ref(ctx), std::ref(buffer), i, std::ref(outputFile), std::cref(options));
+    }
+
+    // Start the snapshot reporter, if requested.
+    std::thread reporter;
+    if (options.snapshotInterval.count() > 0) {
+        reporter = std::thread(snapshotReporter, std::ref(ctx), std::ref(buffer), c, std::ref(outputFile), std::cref(options), startTime);
     }
 
     // Wait for all producer threads to complete.
@@ -184,35 +1798,624 @@ void runSimulation(int p, int c, int b, std::ofstream &outputFile) {
     }
 
     // Signal consumers to terminate after all producers have finished.
-    terminate = true;
+    ctx.terminate = true;
     buffer.notifyAllDone(); // Notify all consumers that no more records will be produced.
 
     // Wait for all consumer threads to complete.
     for (auto &cons : consumers) {
         cons.join();
     }
+    if (reporter.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(ctx.reporterMtx);
+            ctx.reporterStop = true;
+        }
+        ctx.reporterWake.notify_one();
+        reporter.join();
+    }
 
     auto endTime = std::chrono::steady_clock::now(); // Record the simulation end time.
     std::chrono::duration<double> elapsed = endTime - startTime; // Calculate the elapsed simulation time.
 
+    if (sink) {
+        sink->close();
+    }
+
+    SimulationResult result;
+    result.seconds = elapsed.count();
+    result.records = ctx.stats.records;
+    result.latency = ctx.latency;
+    result.buffer = ctx.report;
+
+    if (!options.verbose) {
+        return result;
+    }
+
     // Log the simulation duration to the output file.
     outputFile << "Simulation completed in " << elapsed.count() << " seconds.\n";
 
     // Log global statistics to the output file.
-    outputFile << "Global sales: " << std::fixed << std::setprecision(2) << globalSales << std::endl;
-    outputFile << "Store-wise sales:\n";
-    for (const auto &[storeID, total] : storeSales) {
-        outputFile << "  Store " << storeID << ": " << total << std::endl;
-    }
-    outputFile << "Month-wise sales:\n";
-    for (const auto &[month, total] : monthSales) {
-        outputFile << "  Month " << month << ": " << total << std::endl;
+    printSalesStats(outputFile, ctx.stats);
+    if (options.instrument) {
+        result.buffer.print(outputFile, p, c, result.seconds);
+        if (options.console) {
+            result.buffer.print(std::cout, p, c, result.seconds);
+        }
     }
     outputFile << "--------------------------------------\n";
+    return result;
+}
+
+// Parameters for benchmark mode (--bench).
+struct BenchmarkConfig {
+    int p = 4, c = 4, b = 1024;  // Producers, consumers and buffer size.
+    int repetitions = 5;         // Measured runs.
+    int warmup = 1;              // Unmeasured runs before the measured ones.
+};
+
+// Run one configuration repeatedly without simulated sleeps and report throughput and latency.
+// Results go to the console and to output/benchmark_results.csv and output/benchmark_results.json.
+int runBenchmark(const BenchmarkConfig &config, SimulationOptions options, const std::string &outputDir) {
+    options.simulateSleep = false;
+    options.measureLatency = true;
+    options.verbose = false;
+    if (options.records == 0) {
+        options.records = 1000000; // Default benchmark size.
+    }
+
+    std::ofstream csvFile(outputDir + "/benchmark_results.csv", std::ios::trunc);
+    std::ofstream jsonFile(outputDir + "/benchmark_results.json", std::ios::trunc);
+    if (!csvFile.is_open() || !jsonFile.is_open()) {
+        std::cerr << "Error: Could not open or create benchmark output files!\n";
+        return 1;
+    }
+    csvFile << std::fixed;
+    jsonFile << std::fixed;
+    std::ostream nullOutput(nullptr); // Discards per-run logging.
+
+    std::cout << "Benchmark: p=" << config.p << ", c=" << config.c << ", b=" << config.b
+              << ", backend=" << backendName(options.backend) << ", batch=" << options.batchSize
+              << ", records=" << options.records << ", work=" << options.busyWork
+              << ", warmup=" << config.warmup << ", repetitions=" << config.repetitions << "\n";
+
+    for (int i = 0; i < config.warmup; ++i) {
+        runSimulation(config.p, config.c, config.b, nullOutput, options);
+    }
+
+    csvFile << "backend,batch,p,c,b,records,work,repetition,seconds,records_per_sec,p50_ns,p99_ns,p999_ns,"
+            << "producer_blocked_pct,consumer_blocked_pct,contention_pct,verdict\n";
+    jsonFile << "{\n  \"backend\": \"" << backendName(options.backend) << "\", \"batch\": " << options.batchSize
+             << ", \"p\": " << config.p << ", \"c\": " << config.c << ", \"b\": " << config.b
+             << ", \"records\": " << options.records << ", \"work\": " << options.busyWork << ",\n  \"runs\": [\n";
+
+    std::vector<double> rates; // Records/sec of each measured run.
+    for (int rep = 1; rep <= config.repetitions; ++rep) {
+        SimulationResult result = runSimulation(config.p, config.c, config.b, nullOutput, options);
+        double rate = result.seconds > 0 ? result.records / result.seconds : 0;
+        uint64_t p50 = result.latency.percentile(0.50);
+        uint64_t p99 = result.latency.percentile(0.99);
+        uint64_t p999 = result.latency.percentile(0.999);
+        rates.push_back(rate);
+        const BufferReport &report = result.buffer;
+        double producersBlocked = BufferReport::blockedShare(report.producers, config.p, result.seconds) * 100;
+        double consumersBlocked = BufferReport::blockedShare(report.consumers, config.c, result.seconds) * 100;
+        double contention = report.contention() * 100;
+        std::string verdict = options.instrument ? report.verdict(config.p, config.c, result.seconds) : "n/a";
+
+        std::cout << "  Run " << rep << ": " << std::fixed << std::setprecision(3) << result.seconds << " s, "
+                  << std::setprecision(0) << rate << " records/sec, latency p50=" << p50
+                  << " ns, p99=" << p99 << " ns, p999=" << p999 << " ns, " << verdict << "\n";
+        csvFile << backendName(options.backend) << "," << options.batchSize << "," << config.p << "," << config.c << ","
+                << config.b << "," << options.records << "," << options.busyWork << "," << rep << ","
+                << std::setprecision(6) << result.seconds << "," << std::setprecision(0) << rate << ","
+                << p50 << "," << p99 << "," << p999 << "," << std::setprecision(2) << producersBlocked << ","
+                << consumersBlocked << "," << contention << "," << verdict << "\n";
+        jsonFile << "    {\"repetition\": " << rep << ", \"seconds\": " << std::setprecision(6) << result.seconds
+                 << ", \"records_per_sec\": " << std::setprecision(0) << rate << ", \"p50_ns\": " << p50
+                 << ", \"p99_ns\": " << p99 << ", \"p999_ns\": " << p999 << std::setprecision(2)
+                 << ", \"producer_blocked_pct\": " << producersBlocked << ", \"consumer_blocked_pct\": " << consumersBlocked
+                 << ", \"contention_pct\": " << contention << ", \"verdict\": \"" << verdict << "\"}"
+                 << (rep < config.repetitions ? "," : "") << "\n";
+    }
+
+    std::vector<double> sorted = rates;
+    std::sort(sorted.begin(), sorted.end());
+    double median = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+    jsonFile << "  ],\n  \"median_records_per_sec\": " << std::setprecision(0) << median << "\n}\n";
+    std::cout << "Median: " << std::setprecision(0) << median << " records/sec\n";
+    return 0;
+}
+
+// Parameter grid and scheduling limits for the simulation sweep (the default mode).
+struct SweepConfig {
+    std::vector<int> buffers{3, 10};      // Buffer sizes (b).
+    std::vector<int> producers{2, 5, 10}; // Producer counts (p).
+    std::vector<int> consumers{2, 5, 10}; // Consumer counts (c).
+    int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); // Core budget shared by concurrent runs.
+    int jobs = 0;                         // Most runs in flight at once (0 = no limit beyond the core budget).
+};
+
+// Parse a comma-separated list of positive integers such as "2,5,10". Returns false on malformed input.
+bool parseIntList(const std::string &text, std::vector<int> &out) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        char *end = nullptr;
+        long value = std::strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || value < 1) {
+            return false;
+        }
+        values.push_back(static_cast<int>(value));
+    }
+    if (values.empty()) {
+        return false;
+    }
+    out = values;
+    return true;
+}
+
+// Read a sweep grid from a key=value file, e.g. "producers = 2,5,10". Keys are buffers, producers,
+// consumers, cores and jobs; blank lines and lines starting with '#' are ignored.
+bool loadSweepConfig(const std::string &path, SweepConfig &config, std::string &error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "Could not open sweep config " + path;
+        return false;
+    }
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        line.erase(std::remove_if(line.begin(), line.end(), [](unsigned char ch) { return std::isspace(ch); }), line.end());
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t equals = line.find('=');
+        std::string key = line.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : line.substr(equals + 1);
+        std::vector<int> values;
+        bool ok = parseIntList(value, values);
+        if (ok && key == "buffers") {
+            config.buffers = values;
+        } else if (ok && key == "producers") {
+            config.producers = values;
+        } else if (ok && key == "consumers") {
+            config.consumers = values;
+        } else if (ok && key == "cores" && values.size() == 1) {
+            config.cores = values[0];
+        } else if (ok && key == "jobs" && values.size() == 1) {
+            config.jobs = values[0];
+        } else {
+            error = path + ":" + std::to_string(lineNumber) + ": expected buffers|producers|consumers=N[,N...] or cores|jobs=N";
+            return false;
+        }
+    }
+    return true;
+}
+
+// One configuration of the sweep and what its run produced.
+struct SweepRun {
+    int b = 0, p = 0, c = 0;
+    int cost = 0;           // Cores charged against the budget while the run is in flight.
+    std::ostringstream log; // This run's section of results.txt.
+    double seconds = 0;     // Wall time of the run.
+    long long records = 0;  // Records consumed.
+    bool finished = false;  // Set (under the scheduler mutex) once seconds/records/log are final.
+};
+
+// Run every b×p×c combination of 'config', several at a time. Each run has its own
+// SimulationContext, so runs only share the CPU. A run that spins or does busy work is charged
+// p + c cores (capped at the budget); a run that sleeps 5-40 ms per record is charged nothing,
+// since its threads are almost always idle, and is limited only by config.jobs. Runs start in
+// grid order whenever they fit, and their logs are appended to results.txt in grid order, so
+// the file reads the same as a one-at-a-time sweep.
+int runSweep(const SweepConfig &config, SimulationOptions options, std::ostream &outputFile, std::ostream &timingFile) {
+    std::vector<SweepRun> runs(config.buffers.size() * config.producers.size() * config.consumers.size());
+    size_t index = 0;
+    for (int b : config.buffers) {
+        for (int p : config.producers) {
+            for (int c : config.consumers) {
+                SweepRun &run = runs[index++];
+                run.b = b;
+                run.p = p;
+                run.c = c;
+                run.cost = options.simulateSleep ? 0 : std::min(p + c, config.cores);
+            }
+        }
+    }
+
+    int maxJobs = config.jobs > 0 ? config.jobs : static_cast<int>(runs.size());
+    options.console = maxJobs == 1; // Concurrent runs would interleave their console output.
+
+    std::cout << "Sweep: " << runs.size() << " runs, up to " << maxJobs << " at a time, "
+              << config.cores << " core budget, backend=" << backendName(options.backend) << "\n";
+    timingFile << "Buffer Size (b), Producers (p), Consumers (c), Time (seconds), Records/sec\n";
+
+    std::mutex schedMtx;              // Protects the scheduler state below and SweepRun::finished.
+    std::condition_variable runDone;  // Signaled whenever a run finishes.
+    int coresInUse = 0, inFlight = 0; // Budget currently charged and runs currently executing.
+    size_t completed = 0;             // Runs finished so far.
+    size_t written = 0;               // Runs whose log and timing line have been written out.
+    std::vector<bool> started(runs.size(), false);
+    std::vector<std::thread> threads;
+    auto sweepStart = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(schedMtx);
+    while (written < runs.size()) {
+        // Start every pending run that fits, in grid order.
+        for (size_t i = 0; i < runs.size() && inFlight < maxJobs; ++i) {
+            if (started[i] || coresInUse + runs[i].cost > config.cores) {
+                continue;
+            }
+            started[i] = true;
+            coresInUse += runs[i].cost;
+            inFlight++;
+
+            // Log run number and progress.
+            std::ostringstream header;
+            header << "Starting simulation " << i + 1 << "/" << runs.size() << " (" << std::fixed
+                   << std::setprecision(1) << (static_cast<double>(i + 1) / runs.size()) * 100 << "% completed)";
+            std::cout << header.str() << std::endl;
+            runs[i].log << header.str() << std::endl;
+
+            threads.emplace_back([&, i]() {
+                SweepRun &run = runs[i];
+                auto startTime = std::chrono::steady_clock::now();
+                SimulationResult result = runSimulation(run.p, run.c, run.b, run.log, options);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+                std::lock_guard<std::mutex> guard(schedMtx);
+                run.seconds = elapsed.count();
+                run.records = result.records;
+                run.finished = true;
+                coresInUse -= run.cost;
+                inFlight--;
+                completed++;
+                std::cout << "Simulation (b=" << run.b << ", p=" << run.p << ", c=" << run.c
+                          << ") completed in " << run.seconds << " seconds.\n";
+                runDone.notify_one();
+            });
+        }
+
+        // Write out finished runs in grid order, then wait for the next run to finish.
+        while (written < runs.size() && runs[written].finished) {
+            const SweepRun &run = runs[written++];
+            outputFile << run.log.str();
+            outputFile.flush();
+            timingFile << run.b << ", " << run.p << ", " << run.c << ", " << run.seconds << ", "
+                       << static_cast<long long>(run.seconds > 0 ? run.records / run.seconds : 0) << "\n";
+        }
+        if (written < runs.size()) {
+            size_t seen = completed;
+            runDone.wait(lock, [&]() { return completed != seen; });
+        }
+    }
+    lock.unlock();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::chrono::duration<double> sweepTime = std::chrono::steady_clock::now() - sweepStart;
+    double runTime = 0; // What the same runs would take one after another.
+    for (const SweepRun &run : runs) {
+        runTime += run.seconds;
+    }
+    std::ostringstream summary;
+    summary << "Sweep completed in " << std::fixed << std::setprecision(3) << sweepTime.count() << " seconds ("
+            << runTime << " seconds of runs, " << std::setprecision(2)
+            << (sweepTime.count() > 0 ? runTime / sweepTime.count() : 0) << "x overlap).";
+    logMessage(summary.str(), outputFile);
+    return 0;
+}
+
+// Per-thread totals for aggregateSalesLog. Amounts stay in integer cents, which is exact and
+// cheaper than floating point; each thread's block is cache-line aligned.
+struct alignas(CACHE_LINE) CentsStats {
+    uint64_t totalCents = 0;
+    uint64_t records = 0;
+    std::array<uint64_t, 16> monthCents{};  // Indexed by the 4-bit month field.
+    std::array<uint64_t, 16> monthCounts{};
+    std::array<std::array<uint64_t, 12>, 128> periodCents{};  // Indexed by the 7-bit year field, then month 1..12.
+    std::array<std::array<uint64_t, 12>, 128> periodCounts{};
+    std::vector<uint64_t> storeCents;       // Indexed by storeID below SalesStats::DENSE_STORES (grown on demand).
+    std::vector<uint64_t> storeCounts;
+    std::map<int, std::pair<uint64_t, uint64_t>> otherStores; // Cents and counts for any other (e.g. negative) storeID.
+};
+
+// Aggregate a binary sales log straight from the mapped pages with 'threads' threads
+// and print the totals in the results.txt format. Returns a process exit code.
+int aggregateSalesLog(const std::string &path, int threads) {
+    SalesLogReader reader;
+    std::string error;
+    if (!reader.open(path, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+    const PackedSalesRecord *records = reader.records();
+    uint64_t count = reader.size();
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<CentsStats> partial(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            CentsStats &local = partial[t];
+            uint64_t end = count * (t + 1) / threads;
+            for (uint64_t i = count * t / threads; i < end; ++i) {
+                const PackedSalesRecord &record = records[i]; // Read in place: no copy, no parsing.
+                int storeID = static_cast<int>(record.storeID); // Negative IDs are stored as their two's complement.
+                if (storeID >= 0 && storeID < SalesStats::DENSE_STORES) {
+                    size_t store = static_cast<size_t>(storeID);
+                    if (store >= local.storeCents.size()) {
+                        local.storeCents.resize(store + 1, 0);
+                        local.storeCounts.resize(store + 1, 0);
+                    }
+                    local.storeCents[store] += record.amountCents;
+                    local.storeCounts[store]++;
+                } else { // A corrupt or unusual ID must not size the flat arrays.
+                    auto &entry = local.otherStores[storeID];
+                    entry.first += record.amountCents;
+                    entry.second++;
+                }
+                unsigned month = (record.date >> 5) & 0x0F;
+                local.totalCents += record.amountCents;
+                local.monthCents[month] += record.amountCents;
+                local.monthCounts[month]++;
+                if (month >= 1 && month <= 12) {
+                    unsigned year = record.date >> 9;
+                    local.periodCents[year][month - 1] += record.amountCents;
+                    local.periodCounts[year][month - 1]++;
+                }
+            }
+            local.records = end - count * t / threads;
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    // Merge the per-thread totals and convert them to SalesStats for printing.
+    CentsStats merged;
+    for (const CentsStats &local : partial) {
+        if (local.storeCents.size() > merged.storeCents.size()) {
+            merged.storeCents.resize(local.storeCents.size(), 0);
+            merged.storeCounts.resize(local.storeCounts.size(), 0);
+        }
+        merged.totalCents += local.totalCents;
+        merged.records += local.records;
+        for (size_t i = 0; i < local.storeCents.size(); ++i) {
+            merged.storeCents[i] += local.storeCents[i];
+            merged.storeCounts[i] += local.storeCounts[i];
+        }
+        for (const auto &entry : local.otherStores) {
+            auto &mine = merged.otherStores[entry.first];
+            mine.first += entry.second.first;
+            mine.second += entry.second.second;
+        }
+        for (size_t m = 0; m < merged.monthCents.size(); ++m) {
+            merged.monthCents[m] += local.monthCents[m];
+            merged.monthCounts[m] += local.monthCounts[m];
+        }
+        for (size_t y = 0; y < merged.periodCents.size(); ++y) {
+            for (size_t m = 0; m < 12; ++m) {
+                merged.periodCents[y][m] += local.periodCents[y][m];
+                merged.periodCounts[y][m] += local.periodCounts[y][m];
+            }
+        }
+    }
+    SalesStats stats;
+    stats.total.add(merged.totalCents / 100.0);
+    stats.records = static_cast<long long>(merged.records);
+    stats.storeSales.resize(merged.storeCents.size());
+    stats.storeCounts.resize(merged.storeCounts.size(), 0);
+    for (size_t i = 0; i < merged.storeCents.size(); ++i) {
+        stats.storeSales[i].add(merged.storeCents[i] / 100.0);
+        stats.storeCounts[i] = static_cast<long long>(merged.storeCounts[i]);
+    }
+    for (const auto &entry : merged.otherStores) {
+        auto &store = stats.otherStores[entry.first];
+        store.first.add(entry.second.first / 100.0);
+        store.second = static_cast<long long>(entry.second.second);
+    }
+    for (size_t m = 1; m <= 12; ++m) {
+        stats.monthSales[m].add(merged.monthCents[m] / 100.0);
+        stats.monthCounts[m] = static_cast<long long>(merged.monthCounts[m]);
+    }
+    for (size_t y = 0; y < merged.periodCents.size(); ++y) {
+        for (size_t m = 0; m < 12; ++m) {
+            if (merged.periodCounts[y][m] > 0) { // Rows only for years that had sales, as SalesStats::add does.
+                size_t row = stats.yearRow(static_cast<int>(y));
+                stats.periodSales[row][m].add(merged.periodCents[y][m] / 100.0);
+                stats.periodCounts[row][m] = static_cast<long long>(merged.periodCounts[y][m]);
+            }
+        }
+    }
+
+    double gigabytes = count * sizeof(PackedSalesRecord) / 1e9;
+    std::cout << "Aggregated " << count << " records from " << path << " in " << std::fixed << std::setprecision(3)
+              << elapsed.count() << " s (" << std::setprecision(0) << (elapsed.count() > 0 ? count / elapsed.count() : 0)
+              << " records/sec, " << std::setprecision(2) << (elapsed.count() > 0 ? gigabytes / elapsed.count() : 0) << " GB/s)\n";
+    printSalesStats(std::cout, stats);
+    return 0;
+}
+
+// Write 'records' synthetic records spread over stores 1..stores to a binary sales log,
+// generating straight into the mapped pages. Returns a process exit code.
+int generateSalesLog(const std::string &path, long long records, int stores, uint64_t seed, int firstYear, int years) {
+    SalesLogWriter writer;
+    if (!writer.open(path, static_cast<uint64_t>(records))) {
+        std::cerr << "Error: Could not create sales log " << path << "\n";
+        return 1;
+    }
+    PackedSalesRecord *out = writer.records();
+    std::vector<SalesRecord> chunk(4096);
+    long long written = 0;
+    for (int store = 1; store <= stores; ++store) {
+        RecordRng rng(seed, static_cast<uint64_t>(store)); // Same stream a producer for this store would use.
+        long long storeRecords = records / stores + (store <= records % stores ? 1 : 0);
+        for (long long done = 0; done < storeRecords;) {
+            size_t n = static_cast<size_t>(std::min<long long>(static_cast<long long>(chunk.size()), storeRecords - done));
+            generateRecords(store, chunk.data(), n, rng, firstYear, years);
+            for (size_t k = 0; k < n; ++k) {
+                out[written + static_cast<long long>(k)] = packRecord(chunk[k]);
+            }
+            done += static_cast<long long>(n);
+            written += static_cast<long long>(n);
+        }
+    }
+    writer.close(static_cast<uint64_t>(written));
+    std::cout << "Wrote " << written << " records for " << stores << " stores to " << path << "\n";
+    return 0;
 }
 
 // Main function to manage and execute all simulations.
-int main() {
+// Usage: main [--backend mutex|lockfree|stealing] [--route rr|store] [--batch N] [--flush-ms MS] [--seed N] [--no-instrument]
+//             [--replay LOG] [--record-log LOG] [--snapshot-ms MS] [--years FIRST-LAST]
+//             [--sweep-config FILE] [--buffers N,..] [--producers N,..] [--consumers N,..] [--cores N] [--jobs N] [--no-sleep]
+//             [--bench [-p N] [-c N] [-b N] [--records N] [--reps N] [--warmup N] [--work N]]
+//        main --generate-log LOG [--records N] [-p STORES] [--seed N] [--years FIRST-LAST]
+//        main --aggregate LOG [--threads N]
+int main(int argc, char *argv[]) {
+    SimulationOptions options; // Options shared by every run in the grid.
+    BenchmarkConfig bench;     // Benchmark parameters (only used with --bench).
+    SweepConfig sweep;         // Parameter grid and core budget for the default sweep.
+    bool benchMode = false;    // Run one configuration as a throughput benchmark instead of the grid.
+    std::string replayPath;    // Binary sales log producers replay instead of generating records.
+    std::string generatePath;  // Write a synthetic binary sales log here and exit.
+    std::string aggregatePath; // Aggregate this binary sales log and exit.
+    int aggregateThreads = std::max(1u, std::thread::hardware_concurrency()); // Threads for --aggregate.
+    options.seed = (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}(); // Random unless --seed is given.
+
+    // Parse command-line options.
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "mutex") {
+                options.backend = BufferBackend::Mutex;
+            } else if (name == "lockfree") {
+                options.backend = BufferBackend::LockFree;
+            } else if (name == "stealing") {
+                options.backend = BufferBackend::WorkStealing;
+            } else {
+                std::cerr << "Error: Unknown backend '" << name << "' (expected mutex, lockfree or stealing).\n";
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--route") == 0 && i + 1 < argc) {
+            std::string route = argv[++i];
+            if (route != "rr" && route != "store") {
+                std::cerr << "Error: Unknown route '" << route << "' (expected rr or store).\n";
+                return 1;
+            }
+            options.routeByStore = route == "store";
+        } else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            options.batchSize = std::max(1, std::atoi(argv[++i])); // At least one record per batch.
+        } else if (std::strcmp(argv[i], "--flush-ms") == 0 && i + 1 < argc) {
+            options.flushTimeout = std::chrono::milliseconds(std::max(0, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--no-instrument") == 0) {
+            options.instrument = false;
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--record-log") == 0 && i + 1 < argc) {
+            options.recordLogPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--generate-log") == 0 && i + 1 < argc) {
+            generatePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--aggregate") == 0 && i + 1 < argc) {
+            aggregatePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            aggregateThreads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--sweep-config") == 0 && i + 1 < argc) {
+            std::string error;
+            if (!loadSweepConfig(argv[++i], sweep, error)) {
+                std::cerr << "Error: " << error << "\n";
+                return 1;
+            }
+        } else if ((std::strcmp(argv[i], "--buffers") == 0 || std::strcmp(argv[i], "--producers") == 0 ||
+                    std::strcmp(argv[i], "--consumers") == 0) && i + 1 < argc) {
+            std::vector<int> &list = argv[i][2] == 'b' ? sweep.buffers : argv[i][2] == 'p' ? sweep.producers : sweep.consumers;
+            if (!parseIntList(argv[i + 1], list)) {
+                std::cerr << "Error: " << argv[i] << " expects a comma-separated list of positive integers.\n";
+                return 1;
+            }
+            ++i;
+        } else if (std::strcmp(argv[i], "--cores") == 0 && i + 1 < argc) {
+            sweep.cores = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            sweep.jobs = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--snapshot-ms") == 0 && i + 1 < argc) {
+            options.snapshotInterval = std::chrono::milliseconds(std::max(0, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--years") == 0 && i + 1 < argc) {
+            int first = 0, last = 0;
+            char dash = 0;
+            std::istringstream range(argv[++i]);
+            if (!(range >> first >> dash >> last) || dash != '-' || first < 0 || last < first || last > 127) {
+                std::cerr << "Error: --years expects FIRST-LAST two-digit years with 0 <= FIRST <= LAST <= 127.\n";
+                return 1;
+            }
+            options.firstYear = first;
+            options.years = last - first + 1;
+        } else if (std::strcmp(argv[i], "--no-sleep") == 0) {
+            options.simulateSleep = false;
+        } else if (std::strcmp(argv[i], "--bench") == 0) {
+            benchMode = true;
+        } else if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            bench.p = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            bench.c = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            bench.b = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--records") == 0 && i + 1 < argc) {
+            options.records = std::max(0LL, std::atoll(argv[++i]));
+        } else if (std::strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            bench.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            bench.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--work") == 0 && i + 1 < argc) {
+            options.busyWork = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--backend mutex|lockfree|stealing] [--route rr|store] [--batch N] [--flush-ms MS] [--seed N] [--no-instrument]\n"
+                      << "       [--replay LOG] [--record-log LOG] [--snapshot-ms MS] [--years FIRST-LAST]\n"
+                      << "       [--sweep-config FILE] [--buffers N,..] [--producers N,..] [--consumers N,..] [--cores N] [--jobs N] [--no-sleep]\n"
+                      << "       [--bench [-p N] [-c N] [-b N] [--records N] [--reps N] [--warmup N] [--work N]]\n"
+                      << "   or: " << argv[0] << " --generate-log LOG [--records N] [-p STORES] [--seed N] [--years FIRST-LAST]\n"
+                      << "   or: " << argv[0] << " --aggregate LOG [--threads N]\n";
+            return 1;
+        }
+    }
+
+    // Standalone sales-log tools.
+    if (!generatePath.empty()) {
+        return generateSalesLog(generatePath, options.records > 0 ? options.records : 1000000, bench.p, options.seed,
+                                options.firstYear, options.years);
+    }
+    if (!aggregatePath.empty()) {
+        return aggregateSalesLog(aggregatePath, aggregateThreads);
+    }
+
+    // Every run opens (and truncates) the record log, so only a single run can record one.
+    if (!options.recordLogPath.empty()) {
+        size_t runs = benchMode ? static_cast<size_t>(bench.warmup + bench.repetitions)
+                                : sweep.buffers.size() * sweep.producers.size() * sweep.consumers.size();
+        if (runs != 1) {
+            std::cerr << "Error: --record-log needs exactly one run, but this would start " << runs
+                      << " (use one value each for --buffers/--producers/--consumers, or --bench --reps 1 --warmup 0).\n";
+            return 1;
+        }
+    }
+
+    // Replay: map the log once; every run reads records from the same mapping.
+    SalesLogReader replay;
+    if (!replayPath.empty()) {
+        std::string error;
+        if (!replay.open(replayPath, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+        options.replayRecords = replay.records();
+        options.replayCount = replay.size();
+    }
+
     // Define the directory for storing output files.
     std::string outputDir = "output";
     std::string outputFilePath = outputDir + "/results.txt";
@@ -223,6 +2426,10 @@ int main() {
         fs::create_directories(outputDir);
     }
 
+    if (benchMode) {
+        return runBenchmark(bench, options, outputDir);
+    }
+
     // Open the results file for writing (overwrites any existing file).
     std::ofstream outputFile(outputFilePath, std::ios::trunc);
     std::ofstream timingFile(timingFilePath, std::ios::trunc);
@@ -232,44 +2439,10 @@ int main() {
         return 1;
     }
 
-    // Define the parameters for the simulations.
-    int bufferSizes[] = {3, 10};            // Possible buffer sizes.
-    int producerCounts[] = {2, 5, 10};      // Possible numbers of producers.
-    int consumerCounts[] = {2, 5, 10};      // Possible numbers of consumers.
-    int totalRuns = 18; // Total number of runs (3 buffer sizes * 3 producer counts * 3 consumer counts).
-    int runCounter = 1; // Initialize the run counter.
-
-    timingFile << "Buffer Size (b), Producers (p), Consumers (c), Time (seconds)\n";
-
-    // Run simulations for all combinations of parameters.
-    for (int b : bufferSizes) {
-        for (int p : producerCounts) {
-            for (int c : consumerCounts) {
-                // Calculate the progress percentage.
-                double progress = (static_cast<double>(runCounter) / totalRuns) * 100;
-
-                // Log run number and progress.
-                std::cout << "Starting simulation " << runCounter << "/" << totalRuns
-                          << " (" << std::fixed << std::setprecision(1) << progress << "% completed)" << std::endl;
-                outputFile << "Starting simulation " << runCounter << "/" << totalRuns
-                           << " (" << std::fixed << std::setprecision(1) << progress << "% completed)" << std::endl;
-
-                auto startTime = std::chrono::steady_clock::now();
-                runSimulation(p, c, b, outputFile);
-                auto endTime = std::chrono::steady_clock::now();
-
-                std::chrono::duration<double> elapsed = endTime - startTime;
-
-                timingFile << b << ", " << p << ", " << c << ", " << elapsed.count() << "\n";
-                std::cout << "Simulation (b=" << b << ", p=" << p << ", c=" << c
-                          << ") completed in " << elapsed.count() << " seconds.\n";
-
-                runCounter++; // Increment the run counter.
-            }
-        }
-    }
+    // Run every configuration of the grid, as many at a time as the core budget allows.
+    int status = runSweep(sweep, options, outputFile, timingFile);
 
     outputFile.close();
     timingFile.close(); // Close the results file after all simulations are complete.
-    return 0; // Exit the program successfully.
+    return status;
 }
@@ -5,17 +5,48 @@
 #include <string>
 #include <algorithm>
 #include <unordered_set>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <memory>
+#include <cctype>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <cmath>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 // This program determines the effectiveness of different page replacement programs by analyzing how many page faults they each generate. 
 //The program is designed to take in Byte addresses from a text file that are listed one line at a time.
 //The adjustable variables are: the input file, the number of frames, the page size.
 using namespace std;
 
+typedef uint64_t Address; //byte address from a trace (64-bit, so large address spaces do not overflow)
+typedef uint64_t Page;    //page number (address / page size)
+
+// The four functions below are the straightforward reference implementations: every reference
+// does a std::find over the frames list (O(frames)) and hits/evictions shift the vector.
+// runAlgorithms uses the O(1) engines and the next-use based optimalEngine further down, which
+// give the same fault counts.
+
 // FIFO Page Replacement Algorithm
-double fifoReplacement(const vector<int>& pages, int frames) {
-    vector<int> memory; //This is a representation of the frames list
+double fifoReplacement(const vector<Page>& pages, int frames) {
+    vector<Page> memory; //This is a representation of the frames list
     double faults = 0; //used to track page faults
 
-    for (int page : pages) { //iterate through each page look up and perform the FIFO algorithm
+    for (Page page : pages) { //iterate through each page look up and perform the FIFO algorithm
         if (find(memory.begin(), memory.end(), page) == memory.end()) { // Page fault
             if (memory.size() >= frames) { // if frames are full
                 memory.erase(memory.begin()); // Remove oldest page
@@ -28,11 +59,11 @@ double fifoReplacement(const vector<int>& pages, int frames) {
 }
 
 // LRU Page Replacement Algorithm
-double lruReplacement(const vector<int>& pages, int frames) { 
-    vector<int> memory; //This is a representation of the frames list
+double lruReplacement(const vector<Page>& pages, int frames) { 
+    vector<Page> memory; //This is a representation of the frames list
     double faults = 0; //used to track page faults
 
-    for (int page : pages) {
+    for (Page page : pages) {
         auto it = find(memory.begin(), memory.end(), page);
         if (it != memory.end()) { // Page found
             memory.erase(it);    // Remove it to update its position
@@ -48,11 +79,11 @@ double lruReplacement(const vector<int>& pages, int frames) {
 }
 
 // MRU Page Replacement Algorithm
-double mruReplacement(const vector<int>& pages, int frames) {
-    vector<int> memory; //This is a representation of the frames list
+double mruReplacement(const vector<Page>& pages, int frames) {
+    vector<Page> memory; //This is a representation of the frames list
     double faults = 0; //used to track page faults
 
-    for (int page : pages) {
+    for (Page page : pages) {
         auto it = find(memory.begin(), memory.end(), page);
         if (it != memory.end()) { // Page found
             memory.erase(it);    // Remove it to update its position
@@ -71,12 +102,12 @@ double mruReplacement(const vector<int>& pages, int frames) {
 }
 
 // Optimal Page Replacement Algorithm
-double optimalReplacement(const vector<int>& pages, int numFrames) {
-    vector<int> memory; //This is a representation of the frames list
+double optimalReplacement(const vector<Page>& pages, int numFrames) {
+    vector<Page> memory; //This is a representation of the frames list
     double faults = 0;
 
     for (int i = 0; i < pages.size(); i++) {
-        int currentPage = pages[i]; //current page will be used as the starting point of the optimal search
+        Page currentPage = pages[i]; //current page will be used as the starting point of the optimal search
         auto it = find(memory.begin(), memory.end(), currentPage); //is the current page in the frames list
         if (it != memory.end()) { //page found in frames list
             continue; // No page fault
@@ -112,67 +143,2050 @@ double optimalReplacement(const vector<int>& pages, int numFrames) {
     return faults; //returns the number of page faults for this algorithm based on the selected criteria
 }
 
-// Read file and store addresses
-void readFile(const string& filename, vector<int>& data) {
-    ifstream file(filename);
+// Straightforward versions of the extra policies, written like the four above (std::find over a
+// frames list). They are slow but easy to check by eye, and --bench compares the engines to them.
+
+// CLOCK (Second-Chance) Page Replacement Algorithm
+double clockReplacement(const vector<Page>& pages, int frames) {
+    vector<Page> memory;     //frames, in slot order
+    vector<int> referenced;  //reference bit of each frame
+    size_t hand = 0;         //next frame the clock hand looks at
+    double faults = 0;
+
+    for (Page page : pages) {
+        auto it = find(memory.begin(), memory.end(), page);
+        if (it != memory.end()) { // Page found
+            referenced[it - memory.begin()] = 1; // give it a second chance
+            continue;
+        }
+        if (memory.size() < (size_t)frames) { // free frame
+            memory.push_back(page);
+            referenced.push_back(0);
+        } else {
+            while (referenced[hand]) { // skip (and clear) pages used since the hand last passed
+                referenced[hand] = 0;
+                hand = (hand + 1) % memory.size();
+            }
+            memory[hand] = page; // replace the first page without a second chance
+            referenced[hand] = 0;
+            hand = (hand + 1) % memory.size();
+        }
+        faults++;
+    }
+    return faults;
+}
+
+// LFU Page Replacement Algorithm
+double lfuReplacement(const vector<Page>& pages, int frames) {
+    vector<Page> memory;           //frames
+    vector<long long> count;       //references to each page since it was loaded
+    vector<size_t> reached;        //when each page reached its current count (tie-break: earliest)
+    double faults = 0;
+
+    for (size_t i = 0; i < pages.size(); i++) {
+        auto it = find(memory.begin(), memory.end(), pages[i]);
+        if (it != memory.end()) { // Page found
+            count[it - memory.begin()]++;
+            reached[it - memory.begin()] = i;
+            continue;
+        }
+        if (memory.size() < (size_t)frames) { // free frame
+            memory.push_back(pages[i]);
+            count.push_back(1);
+            reached.push_back(i);
+        } else {
+            size_t victim = 0; // least frequently used
+            for (size_t j = 1; j < memory.size(); j++) {
+                if (count[j] < count[victim] || (count[j] == count[victim] && reached[j] < reached[victim])) {
+                    victim = j;
+                }
+            }
+            memory[victim] = pages[i];
+            count[victim] = 1;
+            reached[victim] = i;
+        }
+        faults++;
+    }
+    return faults;
+}
+
+// ARC Page Replacement Algorithm (lists run from least to most recently used)
+double arcReplacement(const vector<Page>& pages, int frames) {
+    vector<Page> t1, t2;  //resident: seen once recently, seen at least twice
+    vector<Page> b1, b2;  //ghosts: recently evicted from t1, from t2
+    int target = 0;       //how many frames t1 should get
+    double faults = 0;
+
+    auto contains = [](const vector<Page>& list, Page page) { return find(list.begin(), list.end(), page) != list.end(); };
+    auto remove = [](vector<Page>& list, Page page) { list.erase(find(list.begin(), list.end(), page)); };
+    auto replace = [&](bool hitInB2) { // evict the LRU page of t1 or t2 into its ghost list
+        int size1 = (int)t1.size();
+        if (size1 > 0 && (size1 > target || (hitInB2 && size1 == target) || t2.empty())) {
+            b1.push_back(t1.front());
+            t1.erase(t1.begin());
+        } else {
+            b2.push_back(t2.front());
+            t2.erase(t2.begin());
+        }
+    };
+
+    for (Page page : pages) {
+        if (contains(t1, page) || contains(t2, page)) { // Page found
+            remove(contains(t1, page) ? t1 : t2, page);
+            t2.push_back(page);
+            continue;
+        }
+        faults++;
+        if (contains(b1, page)) { // t1 was too small
+            target = min(frames, target + max(1, (int)b2.size() / (int)b1.size()));
+            replace(false);
+            remove(b1, page);
+            t2.push_back(page);
+        } else if (contains(b2, page)) { // t2 was too small
+            target = max(0, target - max(1, (int)b1.size() / (int)b2.size()));
+            replace(true);
+            remove(b2, page);
+            t2.push_back(page);
+        } else {
+            int size1 = (int)(t1.size() + b1.size());
+            int total = size1 + (int)(t2.size() + b2.size());
+            if (size1 == frames) {
+                if ((int)t1.size() < frames) {
+                    b1.erase(b1.begin());
+                    replace(false);
+                } else {
+                    t1.erase(t1.begin());
+                }
+            } else if (total >= frames) {
+                if (total == 2 * frames) {
+                    b2.erase(b2.begin());
+                }
+                replace(false);
+            }
+            t1.push_back(page);
+        }
+    }
+    return faults;
+}
+
+// 2Q Page Replacement Algorithm
+double twoQReplacement(const vector<Page>& pages, int frames) {
+    size_t kin = max(1, frames / 4), kout = max(1, frames / 2);
+    vector<Page> a1in;   //FIFO of pages seen once
+    vector<Page> a1out;  //FIFO of pages recently evicted from a1in (not resident)
+    vector<Page> am;     //LRU list of pages seen again after leaving a1in
+    double faults = 0;
+
+    auto reclaim = [&]() { // free a frame if all are in use
+        if (a1in.size() + am.size() < (size_t)frames) {
+            return;
+        }
+        if (a1in.size() > kin || am.empty()) {
+            if (a1out.size() == kout) {
+                a1out.erase(a1out.begin());
+            }
+            a1out.push_back(a1in.front());
+            a1in.erase(a1in.begin());
+        } else {
+            am.erase(am.begin());
+        }
+    };
+
+    for (Page page : pages) {
+        auto it = find(am.begin(), am.end(), page);
+        if (it != am.end()) { // Page found in am
+            am.erase(it);
+            am.push_back(page);
+            continue;
+        }
+        if (find(a1in.begin(), a1in.end(), page) != a1in.end()) { // Page found in a1in
+            continue;
+        }
+        faults++;
+        auto out = find(a1out.begin(), a1out.end(), page);
+        if (out != a1out.end()) { // seen again soon after leaving a1in
+            a1out.erase(out);
+            reclaim();
+            am.push_back(page);
+        } else {
+            reclaim();
+            a1in.push_back(page);
+        }
+    }
+    return faults;
+}
+
+// Maps a page number to a value ('missing' if the page has none).
+// Pages 0..DENSE_LIMIT-1 use a directly indexed table that grows on demand; any other page
+// (from a large, sparse 64-bit address space) falls back to a hash map.
+template <class Value>
+class PageMap {
+public:
+    static const Page DENSE_LIMIT = 1 << 22; //largest dense table has 4M entries
+
+    explicit PageMap(Value missing) : missing(missing) {}
+
+    Value find(Page page) const {
+        if (page < DENSE_LIMIT) {
+            return page < dense.size() ? dense[page] : missing;
+        }
+        auto it = sparse.find(page);
+        return it == sparse.end() ? missing : it->second;
+    }
+
+    void set(Page page, Value value) {
+        if (page < DENSE_LIMIT) {
+            if (page >= dense.size()) {
+                dense.resize(max((size_t)page + 1, dense.size() * 2), missing); //grow geometrically
+            }
+            dense[page] = value;
+        } else {
+            sparse[page] = value;
+        }
+    }
+
+    void erase(Page page) {
+        if (page < DENSE_LIMIT) {
+            dense[page] = missing;
+        } else {
+            sparse.erase(page);
+        }
+    }
+
+private:
+    Value missing;
+    vector<Value> dense;                //values for small pages
+    unordered_map<Page, Value> sparse;  //values for everything else
+};
+
+// Maps a page number to the frame slot holding it (-1 if not resident).
+class PageIndex : public PageMap<int> {
+public:
+    PageIndex() : PageMap<int>(-1) {}
+};
+
+// Fixed set of frame slots with a page index and an intrusive doubly-linked list threaded
+// through the slots by index, so lookups, moves and evictions are all O(1) and allocation free.
+// The list runs from the oldest (head) to the newest (tail) entry.
+class FrameTable {
+public:
+    explicit FrameTable(int frames) : pageOf(frames), prev(frames), next(frames) {}
+
+    int capacity() const { return (int)pageOf.size(); }
+    bool full() const { return used == capacity(); }
+    int find(Page page) const { return index.find(page); }
+    int head() const { return first; }
+    int tail() const { return last; }
+
+    // Put a page in a free slot (there must be one) at the tail of the list.
+    int insert(Page page) {
+        int frame = used++;
+        pageOf[frame] = page;
+        index.set(page, frame);
+        pushBack(frame);
+        return frame;
+    }
+
+    // Replace the page in 'frame' with 'page' and move the slot to the tail of the list.
+    void replace(int frame, Page page) {
+        index.erase(pageOf[frame]);
+        pageOf[frame] = page;
+        index.set(page, frame);
+        moveToBack(frame);
+    }
+
+    void moveToBack(int frame) {
+        if (frame != last) {
+            unlink(frame);
+            pushBack(frame);
+        }
+    }
+
+private:
+    void pushBack(int frame) {
+        prev[frame] = last;
+        next[frame] = -1;
+        if (last >= 0) {
+            next[last] = frame;
+        } else {
+            first = frame;
+        }
+        last = frame;
+    }
+
+    void unlink(int frame) {
+        if (prev[frame] >= 0) {
+            next[prev[frame]] = next[frame];
+        } else {
+            first = next[frame];
+        }
+        if (next[frame] >= 0) {
+            prev[next[frame]] = prev[frame];
+        } else {
+            last = prev[frame];
+        }
+    }
+
+    PageIndex index;
+    vector<Page> pageOf;     //page held by each frame slot
+    vector<int> prev, next;  //list links by slot index (-1 = none)
+    int first = -1, last = -1;
+    int used = 0;            //slots filled so far (slots are never freed, only reused)
+};
+
+// O(1) FIFO engine: the list is in load order and hits do not touch it, so the victim is the head.
+class FifoEngine {
+public:
+    explicit FifoEngine(int frames) : table(frames) {}
+
+    bool reference(Page page) { //returns true on a page fault
+        if (table.find(page) >= 0) {
+            return false;
+        }
+        if (table.full()) {
+            table.replace(table.head(), page); //remove oldest page
+        } else {
+            table.insert(page);
+        }
+        return true;
+    }
+
+private:
+    FrameTable table;
+};
+
+// O(1) LRU engine: hits move the page to the tail, so the head is the least recently used page.
+class LruEngine {
+public:
+    explicit LruEngine(int frames) : table(frames) {}
+
+    bool reference(Page page) {
+        int frame = table.find(page);
+        if (frame >= 0) {
+            table.moveToBack(frame);
+            return false;
+        }
+        if (table.full()) {
+            table.replace(table.head(), page); //remove least recently used
+        } else {
+            table.insert(page);
+        }
+        return true;
+    }
+
+private:
+    FrameTable table;
+};
+
+// O(1) MRU engine: same recency list as LRU, but a fault evicts the tail (most recently used).
+class MruEngine {
+public:
+    explicit MruEngine(int frames) : table(frames) {}
+
+    bool reference(Page page) {
+        int frame = table.find(page);
+        if (frame >= 0) {
+            table.moveToBack(frame);
+            return false;
+        }
+        if (table.full()) {
+            table.replace(table.tail(), page); //remove most recently used page
+        } else {
+            table.insert(page);
+        }
+        return true;
+    }
+
+private:
+    FrameTable table;
+};
+
+// O(1) CLOCK (Second-Chance) engine: frames form a circle with a reference bit each. A hit sets
+// the bit; on a fault the hand clears set bits as it passes and evicts the first page whose bit is
+// clear, so a page referenced since it was loaded (or last passed) gets a second chance.
+class ClockEngine {
+public:
+    explicit ClockEngine(int frames) : pageOf(frames), referenced(frames) {}
+
+    bool reference(Page page) {
+        int frame = index.find(page);
+        if (frame >= 0) {
+            referenced[frame] = 1;
+            return false;
+        }
+        int capacity = (int)pageOf.size();
+        if (used < capacity) {
+            frame = used++; //hand stays on slot 0, the oldest page, until the frames are full
+        } else {
+            while (referenced[hand]) { //second chance: clear the bit and move on
+                referenced[hand] = 0;
+                hand = (hand + 1) % capacity;
+            }
+            frame = hand;
+            hand = (hand + 1) % capacity;
+            index.erase(pageOf[frame]);
+        }
+        pageOf[frame] = page;
+        referenced[frame] = 0;
+        index.set(page, frame);
+        return true;
+    }
+
+private:
+    PageIndex index;
+    vector<Page> pageOf;
+    vector<uint8_t> referenced; //reference bit per frame
+    int hand = 0;
+    int used = 0;
+};
+
+// O(1) LFU engine: frame slots are kept in buckets of equal reference count, and the buckets in a
+// list of increasing count, so a hit moves its slot to the next bucket (creating it if needed) and a
+// fault evicts from the lowest bucket. Within a bucket the page that reached that count first goes
+// first. Counts are only kept while a page is resident.
+class LfuEngine {
+public:
+    explicit LfuEngine(int frames)
+        : pageOf(frames), prev(frames), next(frames), bucketOf(frames),
+          count(frames + 1), bucketPrev(frames + 1), bucketNext(frames + 1), first(frames + 1), last(frames + 1) {
+        for (int b = frames; b >= 0; b--) { //at most one bucket per resident page, plus one being created
+            freeBuckets.push_back(b);
+        }
+    }
+
+    bool reference(Page page) {
+        int frame = index.find(page);
+        if (frame >= 0) {
+            int bucket = bucketOf[frame];
+            int target = bucketNext[bucket];
+            if (target < 0 || count[target] != count[bucket] + 1) {
+                target = newBucket(count[bucket] + 1, bucket);
+            }
+            detach(frame);
+            attach(frame, target);
+            return false;
+        }
+        if (used < (int)pageOf.size()) {
+            frame = used++;
+        } else {
+            frame = first[lowest]; //least frequently used, earliest to reach that count
+            detach(frame);
+            index.erase(pageOf[frame]);
+        }
+        pageOf[frame] = page;
+        index.set(page, frame);
+        if (lowest < 0 || count[lowest] != 1) {
+            newBucket(1, -1);
+        }
+        attach(frame, lowest);
+        return true;
+    }
+
+private:
+    // Take a bucket from the pool and link it after 'after' (-1 = at the front, as the new lowest).
+    int newBucket(long long references, int after) {
+        int bucket = freeBuckets.back();
+        freeBuckets.pop_back();
+        count[bucket] = references;
+        first[bucket] = last[bucket] = -1;
+        bucketPrev[bucket] = after;
+        bucketNext[bucket] = after >= 0 ? bucketNext[after] : lowest;
+        if (bucketNext[bucket] >= 0) {
+            bucketPrev[bucketNext[bucket]] = bucket;
+        }
+        if (after >= 0) {
+            bucketNext[after] = bucket;
+        } else {
+            lowest = bucket;
+        }
+        return bucket;
+    }
+
+    void attach(int frame, int bucket) { //at the back of the bucket
+        bucketOf[frame] = bucket;
+        prev[frame] = last[bucket];
+        next[frame] = -1;
+        if (last[bucket] >= 0) {
+            next[last[bucket]] = frame;
+        } else {
+            first[bucket] = frame;
+        }
+        last[bucket] = frame;
+    }
+
+    void detach(int frame) { //a bucket left empty goes back to the pool
+        int bucket = bucketOf[frame];
+        if (prev[frame] >= 0) {
+            next[prev[frame]] = next[frame];
+        } else {
+            first[bucket] = next[frame];
+        }
+        if (next[frame] >= 0) {
+            prev[next[frame]] = prev[frame];
+        } else {
+            last[bucket] = prev[frame];
+        }
+        if (first[bucket] < 0) {
+            if (bucketPrev[bucket] >= 0) {
+                bucketNext[bucketPrev[bucket]] = bucketNext[bucket];
+            } else {
+                lowest = bucketNext[bucket];
+            }
+            if (bucketNext[bucket] >= 0) {
+                bucketPrev[bucketNext[bucket]] = bucketPrev[bucket];
+            }
+            freeBuckets.push_back(bucket);
+        }
+    }
+
+    PageIndex index;
+    vector<Page> pageOf;
+    vector<int> prev, next, bucketOf;          //slot links within its bucket (-1 = none)
+    vector<long long> count;                   //reference count of each bucket
+    vector<int> bucketPrev, bucketNext;        //bucket list in increasing count order
+    vector<int> first, last;                   //oldest and newest slot in each bucket
+    vector<int> freeBuckets;
+    int lowest = -1;                           //bucket with the smallest count
+    int used = 0;
+};
+
+// Several page lists sharing one pool of nodes and one page index, for policies that move pages
+// between resident and history ("ghost") lists. Every list runs from oldest to newest and every
+// operation is O(1). A page is in at most one list.
+class PageLists {
+public:
+    PageLists(int lists, int capacity)
+        : first(lists, -1), last(lists, -1), sizes(lists, 0),
+          pageOf(capacity), listOf(capacity), prev(capacity), next(capacity) {
+        for (int node = capacity - 1; node >= 0; node--) {
+            freeNodes.push_back(node);
+        }
+    }
+
+    int find(Page page) const { return index.find(page); } //node holding the page, or -1
+    int list(int node) const { return listOf[node]; }
+    int size(int list) const { return sizes[list]; }
+    int oldest(int list) const { return first[list]; }
+
+    void add(int list, Page page) { //as the newest entry of 'list'
+        int node = freeNodes.back();
+        freeNodes.pop_back();
+        pageOf[node] = page;
+        index.set(page, node);
+        link(node, list);
+    }
+
+    void move(int node, int list) { //to the newest end of 'list' (which may be its own)
+        unlink(node);
+        link(node, list);
+    }
+
+    void remove(int node) {
+        unlink(node);
+        index.erase(pageOf[node]);
+        freeNodes.push_back(node);
+    }
+
+private:
+    void link(int node, int list) {
+        listOf[node] = list;
+        prev[node] = last[list];
+        next[node] = -1;
+        if (last[list] >= 0) {
+            next[last[list]] = node;
+        } else {
+            first[list] = node;
+        }
+        last[list] = node;
+        sizes[list]++;
+    }
+
+    void unlink(int node) {
+        int list = listOf[node];
+        if (prev[node] >= 0) {
+            next[prev[node]] = next[node];
+        } else {
+            first[list] = next[node];
+        }
+        if (next[node] >= 0) {
+            prev[next[node]] = prev[node];
+        } else {
+            last[list] = prev[node];
+        }
+        sizes[list]--;
+    }
+
+    PageIndex index;
+    vector<int> first, last, sizes;  //per list
+    vector<Page> pageOf;             //per node
+    vector<int> listOf, prev, next;  //per node (-1 = no link)
+    vector<int> freeNodes;
+};
+
+// ARC (Megiddo & Modha): resident lists T1 (seen once recently) and T2 (seen at least twice), with
+// ghost lists B1/B2 remembering pages recently evicted from each. A hit in a ghost list moves the
+// target size of T1 towards the list that would have kept the page, so the cache adapts between
+// recency and frequency without tuning. Up to 2 * frames pages are tracked.
+class ArcEngine {
+public:
+    explicit ArcEngine(int frames) : frames(frames), lists(4, 2 * frames) {}
+
+    bool reference(Page page) {
+        int node = lists.find(page);
+        int where = node >= 0 ? lists.list(node) : -1;
+        if (where == T1 || where == T2) { //hit
+            lists.move(node, T2);
+            return false;
+        }
+        if (where == B1) { //T1 was too small: grow its target
+            target = min(frames, target + max(1, lists.size(B2) / lists.size(B1)));
+            replace(false);
+            lists.move(node, T2);
+            return true;
+        }
+        if (where == B2) { //T2 was too small: shrink T1's target
+            target = max(0, target - max(1, lists.size(B1) / lists.size(B2)));
+            replace(true);
+            lists.move(node, T2);
+            return true;
+        }
+        int l1 = lists.size(T1) + lists.size(B1);
+        int total = l1 + lists.size(T2) + lists.size(B2);
+        if (l1 == frames) {
+            if (lists.size(T1) < frames) {
+                lists.remove(lists.oldest(B1));
+                replace(false);
+            } else {
+                lists.remove(lists.oldest(T1)); //B1 is empty: drop the page outright
+            }
+        } else if (total >= frames) {
+            if (total == 2 * frames) {
+                lists.remove(lists.oldest(B2));
+            }
+            replace(false);
+        }
+        lists.add(T1, page);
+        return true;
+    }
+
+private:
+    enum { T1, T2, B1, B2 };
+
+    // Evict the oldest page of T1 or T2 into its ghost list, depending on T1's size versus target.
+    void replace(bool hitInB2) {
+        int t1 = lists.size(T1);
+        if (t1 > 0 && (t1 > target || (hitInB2 && t1 == target) || lists.size(T2) == 0)) {
+            lists.move(lists.oldest(T1), B1);
+        } else {
+            lists.move(lists.oldest(T2), B2);
+        }
+    }
+
+    int frames;
+    int target = 0; //ARC's p: how many frames T1 should get
+    PageLists lists;
+};
+
+// Full 2Q (Johnson & Shasha): new pages enter the FIFO A1in, and only pages referenced again
+// after leaving it (while still remembered in the ghost FIFO A1out) are promoted to the LRU list Am,
+// so one-off scans never push the hot set out. Sizes follow the paper: Kin = frames / 4 and
+// Kout = frames / 2 (at least 1 each).
+class TwoQEngine {
+public:
+    explicit TwoQEngine(int frames)
+        : frames(frames), kin(max(1, frames / 4)), kout(max(1, frames / 2)), lists(3, frames + kout) {}
+
+    bool reference(Page page) {
+        int node = lists.find(page);
+        int where = node >= 0 ? lists.list(node) : -1;
+        if (where == AM) { //hit: most recently used
+            lists.move(node, AM);
+            return false;
+        }
+        if (where == A1IN) { //hit: A1in is FIFO, so nothing changes
+            return false;
+        }
+        if (where == A1OUT) { //referenced again soon after leaving A1in: promote to Am
+            lists.remove(node);
+            reclaim();
+            lists.add(AM, page);
+            return true;
+        }
+        reclaim();
+        lists.add(A1IN, page);
+        return true;
+    }
+
+private:
+    enum { A1IN, AM, A1OUT };
+
+    // Free a frame if all are in use: from A1in while it is over Kin (remembering the page in
+    // A1out), otherwise the least recently used page of Am.
+    void reclaim() {
+        if (lists.size(A1IN) + lists.size(AM) < frames) {
+            return;
+        }
+        if (lists.size(A1IN) > kin || lists.size(AM) == 0) {
+            if (lists.size(A1OUT) == kout) {
+                lists.remove(lists.oldest(A1OUT));
+            }
+            lists.move(lists.oldest(A1IN), A1OUT);
+        } else {
+            lists.remove(lists.oldest(AM));
+        }
+    }
+
+    int frames, kin, kout;
+    PageLists lists;
+};
+
+// Run a trace through an engine and return the number of page faults.
+template <class Engine>
+double countFaults(const vector<Page>& pages, int frames) {
+    Engine engine(frames);
+    double faults = 0;
+    for (Page page : pages) {
+        faults += engine.reference(page);
+    }
+    return faults;
+}
+
+// Fault counter that is fed the trace one chunk at a time, so the trace never has to be in memory.
+class StreamingCounter {
+public:
+    virtual ~StreamingCounter() = default;
+    virtual void feed(const Page* pages, size_t count) = 0;
+    double faults = 0;
+};
+
+template <class Engine>
+class EngineCounter : public StreamingCounter {
+public:
+    explicit EngineCounter(int frames) : engine(frames) {}
+
+    void feed(const Page* pages, size_t count) override {
+        for (size_t i = 0; i < count; i++) {
+            faults += engine.reference(pages[i]);
+        }
+    }
+
+private:
+    Engine engine;
+};
+
+template <class Engine>
+unique_ptr<StreamingCounter> makeCounter(int frames) {
+    return unique_ptr<StreamingCounter>(new EngineCounter<Engine>(frames));
+}
+
+// Backward sweep over the trace: nextUse[i] is the position of the next reference to pages[i]
+// after i, or pages.size() if the page is never referenced again.
+template <class Position>
+vector<Position> buildNextUse(const vector<Page>& pages) {
+    Position never = (Position)pages.size();
+    vector<Position> nextUse(pages.size());
+    PageMap<Position> lastSeen(never); //position of the closest later reference to each page
+    for (size_t i = pages.size(); i-- > 0;) {
+        nextUse[i] = lastSeen.find(pages[i]);
+        lastSeen.set(pages[i], (Position)i);
+    }
+    return nextUse;
+}
+
+// Belady's optimal replacement in two passes: buildNextUse, then an indexed max-heap of the frame
+// slots keyed by when their page is next used, so each reference costs O(log frames) instead of a
+// rescan of the rest of the trace. Among pages that are never used again the earliest loaded one is
+// evicted, exactly as optimalReplacement picks the first such page in its frames list.
+template <class Position>
+double optimalWithNextUse(const vector<Page>& pages, const vector<Position>& nextUse, int numFrames) {
+    struct Entry {
+        Position next;   //next use of the page in this slot (the heap key)
+        Position loaded; //load order, for the tie-break
+        int slot;
+    };
+    PageIndex index;
+    vector<Page> pageOf(numFrames);
+    vector<int> heapPos(numFrames);
+    vector<Entry> heap(numFrames); //keys are kept in the heap itself so comparisons touch no other array
+    int used = 0;
+    Position loads = 0;
+    double faults = 0;
+
+    auto before = [](const Entry& a, const Entry& b) { //true if a should be evicted before b
+        return a.next > b.next || (a.next == b.next && a.loaded < b.loaded);
+    };
+    auto siftUp = [&](int at, Entry entry) {
+        while (at > 0 && before(entry, heap[(at - 1) / 2])) {
+            heap[at] = heap[(at - 1) / 2];
+            heapPos[heap[at].slot] = at;
+            at = (at - 1) / 2;
+        }
+        heap[at] = entry;
+        heapPos[entry.slot] = at;
+    };
+    auto siftDown = [&](int at, Entry entry) {
+        while (true) {
+            int child = 2 * at + 1;
+            if (child >= used) {
+                break;
+            }
+            if (child + 1 < used && before(heap[child + 1], heap[child])) {
+                child++;
+            }
+            if (!before(heap[child], entry)) {
+                break;
+            }
+            heap[at] = heap[child];
+            heapPos[heap[at].slot] = at;
+            at = child;
+        }
+        heap[at] = entry;
+        heapPos[entry.slot] = at;
+    };
+
+    for (size_t i = 0; i < pages.size(); i++) {
+        int slot = index.find(pages[i]);
+        if (slot >= 0) { //page found in frames list: its next use moves later, so it rises in the heap
+            int at = heapPos[slot];
+            Entry entry = heap[at];
+            entry.next = nextUse[i];
+            siftUp(at, entry);
+            continue;
+        }
+        faults++; //Page fault
+        if (used < numFrames) { //if size is not full
+            slot = used++;
+            pageOf[slot] = pages[i];
+            index.set(pages[i], slot);
+            siftUp(used - 1, Entry{nextUse[i], loads++, slot});
+        } else { //replace the page used farthest in the future (the heap root)
+            slot = heap[0].slot;
+            index.erase(pageOf[slot]);
+            pageOf[slot] = pages[i];
+            index.set(pages[i], slot);
+            siftDown(0, Entry{nextUse[i], loads++, slot});
+        }
+    }
+    return faults;
+}
+
+// O(n log frames) optimal replacement; 32-bit positions halve the next-use array for traces under 4G references.
+double optimalEngine(const vector<Page>& pages, int numFrames) {
+    if (numFrames <= 0) {
+        return (double)pages.size();
+    }
+    if (pages.size() < UINT32_MAX) {
+        return optimalWithNextUse<uint32_t>(pages, buildNextUse<uint32_t>(pages), numFrames);
+    }
+    return optimalWithNextUse<uint64_t>(pages, buildNextUse<uint64_t>(pages), numFrames);
+}
+
+// Fenwick (binary indexed) tree of counts over trace positions: point update and prefix sum in O(log n).
+class FenwickTree {
+public:
+    explicit FenwickTree(size_t size) : tree(size + 1, 0) {}
+
+    void add(size_t position, int delta) {
+        for (size_t i = position + 1; i < tree.size(); i += i & (0 - i)) {
+            tree[i] += delta;
+        }
+    }
+
+    long long prefix(size_t position) const { //sum of positions 0..position-1
+        long long sum = 0;
+        for (size_t i = position; i > 0; i -= i & (0 - i)) {
+            sum += tree[i];
+        }
+        return sum;
+    }
+
+private:
+    vector<int> tree;
+};
+
+// Turn a histogram of stack distances (distance d = hit for every frame count >= d) plus the
+// references that miss at every size into faults[f] for f = 0..maxFrames.
+vector<double> faultsFromDistances(const vector<double>& histogram, double alwaysMiss, int maxFrames) {
+    vector<double> faults(maxFrames + 1);
+    double misses = alwaysMiss;
+    for (size_t d = histogram.size(); d-- > (size_t)maxFrames + 1;) {
+        misses += histogram[d]; //distances beyond the largest frame count miss everywhere
+    }
+    for (int f = maxFrames; f >= 0; f--) {
+        faults[f] = misses;
+        if (f < (int)histogram.size()) {
+            misses += histogram[f]; //distance f hits with f frames but misses with f-1
+        }
+    }
+    return faults;
+}
 
-    if (file.is_open()) {
-        int number;
-        while (file >> number) { // Read each integer from the file
-            data.push_back(number);
+// LRU faults for every frame count 0..maxFrames from one pass (Mattson stack distances).
+// A reference's LRU stack distance is 1 + the number of distinct pages touched since the previous
+// reference to the same page. The tree holds a 1 at the latest position of every page, so that
+// count is a range sum: O(log n) per reference.
+vector<double> lruFaultCurve(const vector<Page>& pages, int maxFrames) {
+    FenwickTree latest(pages.size());
+    PageMap<size_t> lastSeen(SIZE_MAX);
+    vector<double> histogram(maxFrames + 2, 0); //distances above maxFrames are folded into the last bucket
+    double coldMisses = 0;
+    for (size_t i = 0; i < pages.size(); i++) {
+        size_t previous = lastSeen.find(pages[i]);
+        if (previous == SIZE_MAX) {
+            coldMisses++; //first reference misses at every size
+        } else {
+            long long distance = latest.prefix(i) - latest.prefix(previous + 1) + 1;
+            histogram[min(distance, (long long)maxFrames + 1)]++;
+            latest.add(previous, -1);
+        }
+        latest.add(i, 1);
+        lastSeen.set(pages[i], i);
+    }
+    return faultsFromDistances(histogram, coldMisses, maxFrames);
+}
+
+// OPT faults for every frame count 0..maxFrames from one pass (Mattson's OPT stack).
+// The top f entries of the stack are exactly what OPT keeps with f frames. On a reference the page
+// moves to the top, and the page pushed out of each level is carried down: at every level the
+// entry used sooner stays and the one used later keeps falling, until the hole the page left (or
+// the bottom) is reached. Only the top maxFrames levels are kept, so a reference costs
+// O(maxFrames) instead of rerunning OPT for each frame count.
+vector<double> optFaultCurve(const vector<Page>& pages, int maxFrames) {
+    vector<uint64_t> nextUse = buildNextUse<uint64_t>(pages);
+    vector<Page> stack;            //pages, most recently placed first
+    vector<uint64_t> stackNext;    //next use of each stacked page
+    vector<double> histogram(maxFrames + 2, 0);
+    double misses = 0;
+    stack.reserve(maxFrames);
+    stackNext.reserve(maxFrames);
+    for (size_t i = 0; i < pages.size(); i++) {
+        int depth = 0;
+        while (depth < (int)stack.size() && stack[depth] != pages[i]) {
+            depth++;
+        }
+        bool found = depth < (int)stack.size();
+        if (found) {
+            histogram[depth + 1]++;
+        } else {
+            misses++;
+        }
+        if (maxFrames == 0) {
+            continue;
+        }
+
+        // Put the page on top and carry the displaced entries down to its old slot.
+        Page carryPage = pages[i];
+        uint64_t carryNext = nextUse[i];
+        int end = found ? depth : (int)stack.size();
+        for (int k = 0; k < end; k++) {
+            if (k == 0 || stackNext[k] > carryNext) { //the level keeps the entry used sooner
+                swap(stack[k], carryPage);
+                swap(stackNext[k], carryNext);
+            }
+        }
+        if (found) {
+            stack[depth] = carryPage; //fill the page's old slot (depth 0: the page itself, with its new next use)
+            stackNext[depth] = carryNext;
+        } else if ((int)stack.size() < maxFrames) {
+            stack.push_back(carryPage); //still room: the last carried entry settles at the bottom
+            stackNext.push_back(carryNext);
+        }
+    }
+    return faultsFromDistances(histogram, misses, maxFrames);
+}
+
+// A whole file mapped read-only, so traces are parsed straight from the page cache without
+// copying them into the heap. Where mmap is not available the file is read into memory instead.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const string& path) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length = (size_t)info.st_size;
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+            madvise(mapped, length, MADV_SEQUENTIAL); //read-ahead, and drop pages once they are behind us
+            bytes = (const char*)mapped;
+        }
+        ::close(fd);
+        return true;
+#else
+        ifstream file(path, ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        copy.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        bytes = copy.data();
+        length = copy.size();
+        return true;
+#endif
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (bytes) {
+            munmap((void*)bytes, length);
+        }
+#else
+        copy.clear();
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    vector<char> copy;
+#endif
+};
+
+// Binary trace file: a 24-byte header followed by the addresses.
+// FIXED stores every address as a little-endian uint64. VARINT stores the difference from the
+// previous address, zigzag-mapped and LEB128-encoded, so the small strides of real programs take
+// one or two bytes per reference.
+struct TraceHeader {
+    char magic[8];     //"PGTRACE1"
+    uint32_t encoding; //TRACE_FIXED or TRACE_VARINT
+    uint32_t reserved; //0
+    uint64_t count;    //number of addresses
+};
+const char TRACE_MAGIC[8] = {'P', 'G', 'T', 'R', 'A', 'C', 'E', '1'};
+const uint32_t TRACE_FIXED = 0;
+const uint32_t TRACE_VARINT = 1;
+
+// Reads addresses in chunks from a text trace (one decimal or 0x-hex address per line, optionally
+// signed) or a binary trace, detected by its header. Nothing but the mapping is held, so memory
+// does not grow with the trace length.
+class TraceReader {
+public:
+    bool open(const string& path, string& error) {
+        if (!file.open(path)) {
+            error = "Could not open the file: " + path;
+            return false;
         }
+        pos = file.data();
+        end = pos + file.size();
+        format = TEXT;
+        if (file.size() >= sizeof(TraceHeader) && memcmp(pos, TRACE_MAGIC, sizeof(TRACE_MAGIC)) == 0) {
+            TraceHeader header;
+            memcpy(&header, pos, sizeof(header));
+            if (header.encoding != TRACE_FIXED && header.encoding != TRACE_VARINT) {
+                error = path + ": unknown trace encoding " + to_string(header.encoding);
+                return false;
+            }
+            format = header.encoding == TRACE_FIXED ? FIXED : VARINT;
+            remaining = header.count;
+            pos += sizeof(header);
+            if (format == FIXED && remaining > (uint64_t)(end - pos) / sizeof(uint64_t)) {
+                error = path + ": truncated trace";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Number of addresses in a binary trace, or a rough guess for a text trace (for reserving memory).
+    uint64_t sizeHint() const { return format == TEXT ? (uint64_t)(end - pos) / 6 : remaining; }
+
+    // Fill 'out' with up to 'max' addresses; returns how many, 0 at the end of the trace.
+    size_t read(Address* out, size_t max) {
+        size_t n = 0;
+        if (format == TEXT) {
+            while (n < max && !stopped && parseText(out[n])) {
+                n++;
+            }
+        } else if (format == FIXED) {
+            n = (size_t)min<uint64_t>(max, remaining);
+            memcpy(out, pos, n * sizeof(uint64_t)); //little-endian hosts store uint64 in file order
+            pos += n * sizeof(uint64_t);
+            remaining -= n;
+        } else {
+            for (; n < max && remaining > 0; n++, remaining--) {
+                uint64_t zigzag = 0;
+                int shift = 0;
+                while (true) {
+                    if (pos == end || shift > 63) {
+                        error = "truncated or corrupt varint trace";
+                        remaining = 0;
+                        return n;
+                    }
+                    uint8_t byte = (uint8_t)*pos++;
+                    zigzag |= (uint64_t)(byte & 0x7F) << shift;
+                    if (!(byte & 0x80)) {
+                        break;
+                    }
+                    shift += 7;
+                }
+                previous += (zigzag >> 1) ^ (0 - (zigzag & 1)); //undo zigzag, then the delta
+                out[n] = previous;
+            }
+        }
+        return n;
+    }
+
+    // Non-empty if reading stopped early (e.g. text that is not an address); the addresses read so far are kept.
+    const string& problem() const { return error; }
+
+private:
+    bool parseText(Address& address) {
+        while (pos < end && isspace((unsigned char)*pos)) {
+            pos++;
+        }
+        if (pos == end) {
+            return false;
+        }
+        Address value = 0;
+        const char* start = pos;
+        bool negative = *pos == '-';
+        if (*pos == '-' || *pos == '+') { //signed like 'file >> number'; negative addresses wrap to 2^64 - n
+            pos++;
+        }
+        const char* digits = pos;
+        bool overflow = false;
+        if (end - pos > 2 && pos[0] == '0' && (pos[1] == 'x' || pos[1] == 'X') && isxdigit((unsigned char)pos[2])) {
+            for (pos += 2; pos < end && isxdigit((unsigned char)*pos); pos++) {
+                char c = *pos;
+                overflow |= value > UINT64_MAX >> 4;
+                value = value * 16 + (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+            }
+        } else {
+            for (; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+                Address digit = *pos - '0';
+                overflow |= value > (UINT64_MAX - digit) / 10;
+                value = value * 10 + digit;
+            }
+        }
+        if (overflow) { //like 'file >> number', which fails rather than wrapping
+            error = "stopped at byte " + to_string(start - file.data()) + ": address does not fit in 64 bits";
+            stopped = true;
+            return false;
+        }
+        if (pos == digits || (pos < end && !isspace((unsigned char)*pos))) { //like 'file >> number', stop at anything else
+            error = "stopped at byte " + to_string(start - file.data()) + ": not an address";
+            stopped = true;
+            return false;
+        }
+        address = negative ? 0 - value : value;
+        return true;
+    }
+
+    enum Format { TEXT, FIXED, VARINT };
+    MappedFile file;
+    const char* pos = nullptr;
+    const char* end = nullptr;
+    Format format = TEXT;
+    uint64_t remaining = 0;  //addresses left in a binary trace
+    Address previous = 0;    //last address decoded (VARINT)
+    bool stopped = false;
+    string error;
+};
+
+// Writes a binary trace. The address count in the header is filled in by close().
+class TraceWriter {
+public:
+    bool open(const string& path, uint32_t traceEncoding) {
+        encoding = traceEncoding;
+        file.open(path, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        TraceHeader header = {};
+        memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        header.encoding = encoding;
+        file.write((const char*)&header, sizeof(header));
+        return true;
+    }
+
+    void write(const Address* addresses, size_t n) {
+        buffer.clear();
+        for (size_t i = 0; i < n; i++) {
+            if (encoding == TRACE_FIXED) {
+                uint64_t value = addresses[i];
+                buffer.append((const char*)&value, sizeof(value)); //little-endian hosts
+            } else {
+                uint64_t delta = addresses[i] - previous;
+                uint64_t zigzag = (delta << 1) ^ (0 - (delta >> 63)); //small negative strides stay small
+                previous = addresses[i];
+                while (zigzag >= 0x80) {
+                    buffer.push_back((char)(zigzag | 0x80));
+                    zigzag >>= 7;
+                }
+                buffer.push_back((char)zigzag);
+            }
+        }
+        file.write(buffer.data(), buffer.size());
+        count += n;
+    }
+
+    bool close() {
+        file.seekp(offsetof(TraceHeader, count));
+        file.write((const char*)&count, sizeof(count));
         file.close();
+        return !file.fail();
+    }
+
+    uint64_t size() const { return count; }
+
+private:
+    ofstream file;
+    uint32_t encoding = TRACE_FIXED;
+    Address previous = 0;
+    uint64_t count = 0;
+    string buffer;
+};
+
+// Read file and store addresses
+void readFile(const string& filename, vector<Address>& data) {
+    TraceReader reader;
+    string error;
+    if (!reader.open(filename, error)) {
+        cerr << error << endl;
+        return;
+    }
+    data.reserve(data.size() + reader.sizeHint());
+    const size_t chunk = 1 << 16;
+    while (true) { // Read the addresses chunk by chunk straight into the vector
+        size_t used = data.size();
+        data.resize(used + chunk);
+        size_t n = reader.read(data.data() + used, chunk);
+        data.resize(used + n);
+        if (n == 0) {
+            break;
+        }
+    }
+    if (!reader.problem().empty()) {
+        cerr << filename << ": " << reader.problem() << endl;
+    }
+}
+
+// Convert 'count' addresses to pages (shared by the in-memory and streaming paths)
+void makePages(const Address* addresses, size_t count, int pageSize, Page* pages) {
+    if ((pageSize & (pageSize - 1)) == 0) { //power of two: divide by shifting
+        int shift = 0;
+        while ((1 << shift) < pageSize) {
+            shift++;
+        }
+        for (size_t i = 0; i < count; i++) {
+            pages[i] = addresses[i] >> shift;
+        }
     } else {
-        cerr << "Could not open the file: " << filename << endl;
+        for (size_t i = 0; i < count; i++) {
+            pages[i] = addresses[i] / pageSize; // Calculate page number based on the page size
+        }
     }
 }
 
 // Convert addresses to pages
-vector<int> makePages(const vector<int>& addresses, int pageSize) {
-    vector<int> pages;
-    for (int address : addresses) {
-        pages.push_back(address / pageSize); // Calculate page number based on the page size
-    }
+vector<Page> makePages(const vector<Address>& addresses, int pageSize) {
+    vector<Page> pages(addresses.size());
+    makePages(addresses.data(), addresses.size(), pageSize, pages.data());
     return pages;
 }
 
+// Counts distinct pages as they stream past, without keeping the trace.
+class DistinctPages {
+public:
+    void add(Page page) {
+        if (!seen.find(page)) {
+            seen.set(page, 1);
+            count++;
+        }
+    }
+    long long size() const { return count; }
+
+private:
+    PageMap<uint8_t> seen{0};
+    long long count = 0;
+};
+
 // Count unique pages
-int countUniquePages(const vector<int>& pages) {
-    unordered_set<int> uniquePages(pages.begin(), pages.end());
-    return uniquePages.size(); //counts the unique number of different pages to use as an output to the print function
+int countUniquePages(const vector<Page>& pages) {
+    DistinctPages uniquePages;
+    for (Page page : pages) {
+        uniquePages.add(page);
+    }
+    return (int)uniquePages.size(); //counts the unique number of different pages to use as an output to the print function
 }
 
 // Print results
-void print(int pageSize, int numPages, int frames, const vector<double>& faults) {
+void print(int pageSize, int numPages, int frames, const vector<double>& faults, const vector<string>& algorithms) {
     cout << setw(10) << "Page Size" << setw(15) << "# Pages" << setw(15) << "# Frames"
          << setw(15) << "Algorithm" << setw(20) << "Fault %" << endl;
 
-    vector<string> algorithms = {"FIFO", "LRU", "MRU", "Optimal"};
     for (int i = 0; i < faults.size(); i++) {
         cout << setw(10) << pageSize << setw(15) << numPages << setw(15) << frames
              << setw(15) << algorithms[i] << setw(20) << faults[i] << endl;
     }
 }
 
+// A page trace plus the preprocessing shared by every job that runs on it.
+struct PageTrace {
+    int pageSize = 0;
+    vector<Page> pages;
+    int numPages = 0;          //distinct pages
+    vector<uint32_t> nextUse;  //built once per trace when Optimal is selected (traces under 4G references)
+};
+
+// A replacement algorithm that runAlgorithms and the sweep can run: returns the page faults for 'frames' frames.
+struct Algorithm {
+    string name;
+    bool needsNextUse; //wants trace.nextUse
+    double (*run)(const PageTrace& trace, int frames);
+    unique_ptr<StreamingCounter> (*stream)(int frames); //chunk-fed version, or null if the algorithm needs the whole trace
+    double (*reference)(const vector<Page>& pages, int frames); //straightforward version --bench checks against
+};
+
+template <class Engine>
+double runEngine(const PageTrace& trace, int frames) {
+    return countFaults<Engine>(trace.pages, frames);
+}
+
+double runOptimal(const PageTrace& trace, int frames) {
+    if (trace.nextUse.size() != trace.pages.size() || frames <= 0) {
+        return optimalEngine(trace.pages, frames);
+    }
+    return optimalWithNextUse<uint32_t>(trace.pages, trace.nextUse, frames);
+}
+
+// Registered algorithms, in the order they are printed. To add a policy, write an engine with
+// bool reference(Page) and list it here.
+const vector<Algorithm>& allAlgorithms() {
+    static const vector<Algorithm> algorithms = {
+        {"FIFO", false, runEngine<FifoEngine>, makeCounter<FifoEngine>, fifoReplacement},
+        {"LRU", false, runEngine<LruEngine>, makeCounter<LruEngine>, lruReplacement},
+        {"MRU", false, runEngine<MruEngine>, makeCounter<MruEngine>, mruReplacement},
+        {"Optimal", true, runOptimal, nullptr, optimalReplacement}, //needs the future of the trace
+        {"CLOCK", false, runEngine<ClockEngine>, makeCounter<ClockEngine>, clockReplacement},
+        {"LFU", false, runEngine<LfuEngine>, makeCounter<LfuEngine>, lfuReplacement},
+        {"ARC", false, runEngine<ArcEngine>, makeCounter<ArcEngine>, arcReplacement},
+        {"2Q", false, runEngine<TwoQEngine>, makeCounter<TwoQEngine>, twoQReplacement},
+    };
+    return algorithms;
+}
+
+// Lists of parameters for the sweep; every combination is run.
+struct SweepConfig {
+    vector<int> pageSizes = {512, 1024, 2048};
+    vector<int> frames = {4, 8, 12};
+    vector<string> algorithms; //names to run, in print order (empty = every registered algorithm)
+    int threads = (int)max(1u, thread::hardware_concurrency());
+    string csvPath; //also write the results here as CSV (empty = no CSV)
+};
+
+// Look up the algorithms named in config.algorithms. With 'streaming', algorithms that need the
+// whole trace are left out (with a note). Returns false if a name is unknown.
+bool selectAlgorithms(const SweepConfig& config, bool streaming, vector<const Algorithm*>& selected) {
+    vector<string> names = config.algorithms;
+    if (names.empty()) {
+        for (const Algorithm& algorithm : allAlgorithms()) {
+            names.push_back(algorithm.name);
+        }
+    }
+    for (const string& name : names) {
+        const Algorithm* found = nullptr;
+        for (const Algorithm& algorithm : allAlgorithms()) {
+            if (algorithm.name == name) {
+                found = &algorithm;
+            }
+        }
+        if (!found) {
+            cerr << "Unknown algorithm: " << name << endl;
+            return false;
+        }
+        if (streaming && !found->stream) {
+            cerr << found->name << " needs the whole trace in memory; skipped with --stream" << endl;
+            continue;
+        }
+        selected.push_back(found);
+    }
+    if (selected.empty()) { //e.g. only Optimal with --stream
+        cerr << "No algorithm left to run" << (streaming ? " with --stream" : "") << endl;
+        return false;
+    }
+    return true;
+}
+
+// Run body(0..count-1) on up to 'threads' worker threads.
+template <class Body>
+void parallelFor(size_t count, int threads, Body body) {
+    atomic<size_t> nextJob(0);
+    vector<thread> workers;
+    for (int t = 0; t < (int)min(count, (size_t)threads); t++) {
+        workers.emplace_back([&]() {
+            for (size_t job; (job = nextJob++) < count;) {
+                body(job);
+            }
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// Print the merged sweep table (and CSV) in page size / frames / algorithm order.
+// faults[(pageSize * frames.size() + frames) * selected.size() + algorithm] holds each fault count.
+int printSweep(const SweepConfig& config, const vector<int>& numPages, double references,
+               const vector<const Algorithm*>& selected, const vector<double>& faults) {
+    ofstream csv;
+    if (!config.csvPath.empty()) {
+        csv.open(config.csvPath);
+        if (!csv.is_open()) {
+            cerr << "Could not open the file: " << config.csvPath << endl;
+            return 1;
+        }
+        csv << "page_size,pages,frames,algorithm,faults,fault_pct\n";
+    }
+    vector<string> names;
+    for (const Algorithm* algorithm : selected) {
+        names.push_back(algorithm->name);
+    }
+    size_t slot = 0;
+    for (size_t t = 0; t < config.pageSizes.size(); t++) {
+        for (size_t f = 0; f < config.frames.size(); f++) {
+            vector<double> percent(selected.size());
+            for (size_t a = 0; a < selected.size(); a++, slot++) {
+                percent[a] = faults[slot] / references * 100;
+                if (csv.is_open()) {
+                    csv << config.pageSizes[t] << "," << numPages[t] << "," << config.frames[f] << ","
+                        << names[a] << "," << (long long)faults[slot] << "," << percent[a] << "\n";
+                }
+            }
+            print(config.pageSizes[t], numPages[t], config.frames[f], percent, names);
+        }
+    }
+    return 0;
+}
+
+// Run every (page size, frames, algorithm) combination. Each page-size trace (and its next-use
+// array, if Optimal is selected) is built once and shared read-only by all jobs on it; the
+// independent jobs are spread over config.threads worker threads, most expensive first.
+// Results are printed in the same blocks as print(), one per page size and frame count.
+int runSweep(const vector<Address>& data, const SweepConfig& config) {
+    vector<const Algorithm*> selected;
+    if (!selectAlgorithms(config, false, selected)) {
+        return 1;
+    }
+    bool needNextUse = false;
+    for (const Algorithm* algorithm : selected) {
+        needNextUse = needNextUse || algorithm->needsNextUse;
+    }
+
+    // Build the traces (one per page size) in parallel.
+    vector<PageTrace> traces(config.pageSizes.size());
+    parallelFor(traces.size(), config.threads, [&](size_t i) {
+        PageTrace& trace = traces[i];
+        trace.pageSize = config.pageSizes[i];
+        trace.pages = makePages(data, trace.pageSize);
+        trace.numPages = countUniquePages(trace.pages);
+        if (needNextUse && trace.pages.size() < UINT32_MAX) {
+            trace.nextUse = buildNextUse<uint32_t>(trace.pages);
+        }
+    });
+
+    // One job per (trace, frames, algorithm). Optimal jobs go first: they take the longest.
+    struct Job {
+        size_t trace, frames, algorithm;
+    };
+    vector<Job> jobs;
+    for (size_t t = 0; t < traces.size(); t++) {
+        for (size_t f = 0; f < config.frames.size(); f++) {
+            for (size_t a = 0; a < selected.size(); a++) {
+                jobs.push_back({t, f, a});
+            }
+        }
+    }
+    stable_partition(jobs.begin(), jobs.end(), [&](const Job& job) { return selected[job.algorithm]->needsNextUse; });
+    vector<double> faults(jobs.size());
+    parallelFor(jobs.size(), config.threads, [&](size_t i) {
+        const Job& job = jobs[i];
+        size_t slot = (job.trace * config.frames.size() + job.frames) * selected.size() + job.algorithm;
+        faults[slot] = selected[job.algorithm]->run(traces[job.trace], config.frames[job.frames]);
+    });
+
+    vector<int> numPages;
+    for (const PageTrace& trace : traces) {
+        numPages.push_back(trace.numPages);
+    }
+    return printSweep(config, numPages, (double)data.size(), selected, faults);
+}
+
+// Streaming sweep: the same table as runSweep, but the trace is never loaded. Each worker maps
+// the trace itself and reads it chunk by chunk, converting each chunk to pages for the page sizes
+// it needs and feeding its share of the (page size, frames, algorithm) counters, so memory stays
+// flat however long the trace is. Algorithms that need the whole trace (Optimal) are skipped.
+int runStreamingSweep(const string& input, const SweepConfig& config) {
+    vector<const Algorithm*> selected;
+    if (!selectAlgorithms(config, true, selected)) {
+        return 1;
+    }
+    size_t perPageSize = config.frames.size() * selected.size();
+    size_t jobCount = config.pageSizes.size() * perPageSize;
+    int workers = (int)max<size_t>(1, min(jobCount, (size_t)config.threads));
+    vector<double> faults(jobCount);
+    vector<int> numPages(config.pageSizes.size());
+    atomic<long long> references(0);
+    atomic<bool> failed(false);
+
+    parallelFor(workers, workers, [&](size_t worker) {
+        // This worker's counters: jobs worker, worker + workers, ...; the worker with a page size's
+        // first job also counts its distinct pages (and worker 0 counts references).
+        vector<unique_ptr<StreamingCounter>> counters(jobCount);
+        vector<unique_ptr<DistinctPages>> distinct(config.pageSizes.size());
+        vector<bool> pageSizeUsed(config.pageSizes.size(), false);
+        for (size_t job = worker; job < jobCount; job += workers) {
+            size_t t = job / perPageSize;
+            size_t f = job % perPageSize / selected.size();
+            counters[job] = selected[job % selected.size()]->stream(config.frames[f]);
+            pageSizeUsed[t] = true;
+            if (job % perPageSize == 0) {
+                distinct[t].reset(new DistinctPages());
+            }
+        }
+
+        TraceReader reader;
+        string error;
+        if (!reader.open(input, error)) {
+            if (!failed.exchange(true)) {
+                cerr << error << endl;
+            }
+            return;
+        }
+        const size_t chunk = 1 << 16;
+        vector<Address> addresses(chunk);
+        vector<Page> pages(chunk);
+        long long seen = 0;
+        for (size_t n; (n = reader.read(addresses.data(), chunk)) > 0;) {
+            seen += (long long)n;
+            for (size_t t = 0; t < config.pageSizes.size(); t++) {
+                if (!pageSizeUsed[t]) {
+                    continue;
+                }
+                makePages(addresses.data(), n, config.pageSizes[t], pages.data());
+                if (distinct[t]) {
+                    for (size_t i = 0; i < n; i++) {
+                        distinct[t]->add(pages[i]);
+                    }
+                }
+                for (size_t job = t * perPageSize; job < (t + 1) * perPageSize; job++) {
+                    if (counters[job]) {
+                        counters[job]->feed(pages.data(), n);
+                    }
+                }
+            }
+        }
+        if (worker == 0) {
+            references = seen;
+            if (!reader.problem().empty()) {
+                cerr << input << ": " << reader.problem() << endl;
+            }
+        }
+        for (size_t job = 0; job < jobCount; job++) {
+            if (counters[job]) {
+                faults[job] = counters[job]->faults;
+            }
+        }
+        for (size_t t = 0; t < distinct.size(); t++) {
+            if (distinct[t]) {
+                numPages[t] = (int)distinct[t]->size();
+            }
+        }
+    });
+    if (failed) {
+        return 1;
+    }
+    return printSweep(config, numPages, (double)references, selected, faults);
+}
+
+// Convert a text or binary trace to a binary trace, streaming it chunk by chunk.
+int convertTrace(const string& input, const string& output, uint32_t encoding) {
+    TraceReader reader;
+    TraceWriter writer;
+    string error;
+    if (!reader.open(input, error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    if (!writer.open(output, encoding)) {
+        cerr << "Could not open the file: " << output << endl;
+        return 1;
+    }
+    vector<Address> addresses(1 << 16);
+    for (size_t n; (n = reader.read(addresses.data(), addresses.size())) > 0;) {
+        writer.write(addresses.data(), n);
+    }
+    if (!reader.problem().empty()) {
+        cerr << input << ": " << reader.problem() << endl;
+    }
+    if (!writer.close()) {
+        cerr << "Could not write the file: " << output << endl;
+        return 1;
+    }
+    cout << "Wrote " << writer.size() << " addresses to " << output << " ("
+         << (encoding == TRACE_FIXED ? "fixed" : "varint") << " encoding)" << endl;
+    return 0;
+}
+
+// Parse a comma-separated list such as "512,1024,2048" (numbers must be positive).
+bool parseList(const string& text, vector<string>& out) {
+    out.clear();
+    stringstream stream(text);
+    string item;
+    while (getline(stream, item, ',')) {
+        if (item.empty()) {
+            return false;
+        }
+        out.push_back(item);
+    }
+    return !out.empty();
+}
+
+bool parseList(const string& text, vector<int>& out) {
+    vector<string> items;
+    if (!parseList(text, items)) {
+        return false;
+    }
+    out.clear();
+    for (const string& item : items) {
+        char* end = nullptr;
+        long value = strtol(item.c_str(), &end, 10);
+        if (*end != '\0' || value < 1) {
+            return false;
+        }
+        out.push_back((int)value);
+    }
+    return true;
+}
+
 // Run all algorithms
-void runAlgorithms(vector<int>& data) {
+void runAlgorithms(vector<Address>& data) {
     int frames = 12; //sets the number of memory frames 
     int pageSize = 2048; //sets the system page size
-    vector<double> faults(4,0); //Initialize the vector to be size 4 (one for each algorithm) and default values of zero
-    vector<int> pages = makePages(data, pageSize); //takes the Byte addresses and converts them into pages 
+    PageTrace trace; //the pages shared by every algorithm
+    trace.pageSize = pageSize;
+    trace.pages = makePages(data, pageSize); //takes the Byte addresses and converts them into pages 
+    trace.numPages = countUniquePages(trace.pages); //finds the unique amount of pages.
+
+    vector<double> faults; //fault % of each registered algorithm, in print order
+    vector<string> names;
+    for (const Algorithm& algorithm : allAlgorithms()) {
+        faults.push_back(algorithm.run(trace, frames) / data.size() * 100); //returns how many page faults will occur with this algorithm
+        names.push_back(algorithm.name);
+    }
+    print(pageSize, trace.numPages, frames, faults, names); //prints the fault information in a table format.
+}
+
+// Print a miss-ratio curve: LRU and OPT fault % for every frame count from 1 to maxFrames
+void printMissCurve(int pageSize, int numPages, size_t references, const vector<double>& lru, const vector<double>& opt) {
+    cout << setw(10) << "Page Size" << setw(15) << "# Pages" << setw(15) << "# Frames"
+         << setw(20) << "LRU Fault %" << setw(20) << "Optimal Fault %" << endl;
+    for (size_t frames = 1; frames < lru.size(); frames++) {
+        cout << setw(10) << pageSize << setw(15) << numPages << setw(15) << frames
+             << setw(20) << lru[frames] / references * 100 << setw(20) << opt[frames] / references * 100 << endl;
+    }
+}
+
+const int MRC_DEFAULT_FRAMES = 1024; //largest frame count --mrc shows unless --max-frames is given
+
+// Miss-ratio curve mode: one LRU pass and one OPT pass give the faults for every frame count up to
+// maxFrames. The OPT pass costs O(references * maxFrames), so the default is the number of distinct
+// pages (beyond which only first references miss) capped at MRC_DEFAULT_FRAMES.
+void runMissCurve(vector<Address>& data, int pageSize, int maxFrames) {
+    vector<Page> pages = makePages(data, pageSize); //takes the Byte addresses and converts them into pages
     int numPages = countUniquePages(pages); //finds the unique amount of pages.
+    if (maxFrames <= 0) {
+        maxFrames = min(numPages, MRC_DEFAULT_FRAMES);
+        if (numPages > MRC_DEFAULT_FRAMES) {
+            cerr << "--mrc: curve stops at " << MRC_DEFAULT_FRAMES << " frames (" << numPages << " distinct pages)"
+                 << "; use --max-frames N for more (the OPT pass takes time proportional to N)" << endl;
+        }
+    }
+    vector<double> lru = lruFaultCurve(pages, maxFrames); //stack distances via a Fenwick tree, O(log n) per reference
+    vector<double> opt = optFaultCurve(pages, maxFrames); //OPT stack truncated to maxFrames levels
+    printMissCurve(pageSize, numPages, data.size(), lru, opt);
+}
+
+// Settings for --bench: which synthetic traces to generate and how to time and check the engines.
+struct BenchConfig {
+    vector<string> traces = {"uniform", "zipf", "loop", "phase"};
+    long long length = 1000000;     //references per trace
+    int pages = 10000;              //distinct pages the generators draw from
+    double zipfSkew = 1.0;          //zipf exponent: page k is referenced in proportion to 1 / (k + 1)^s
+    int warmup = 1;                 //untimed runs before timing
+    int repetitions = 3;            //timed runs; the median is reported
+    long long checkLength = 20000;  //trace prefix compared with the reference implementations (0 = no check)
+    uint64_t seed = 1;
+};
+
+// Synthetic page traces:
+//   uniform - every page equally likely
+//   zipf    - a few hot pages and a long tail (skew config.zipfSkew)
+//   loop    - a sequential scan over all pages, repeated (LRU and FIFO's worst case)
+//   phase   - ten phases, each referencing a random working set of pages / 20 consecutive pages
+// Returns an empty trace for an unknown kind.
+vector<Page> generateTrace(const string& kind, const BenchConfig& config) {
+    mt19937_64 random(config.seed);
+    Page pages = (Page)max(1, config.pages);
+    vector<Page> trace;
+    if (kind == "uniform") {
+        uniform_int_distribution<Page> page(0, pages - 1);
+        for (long long i = 0; i < config.length; i++) {
+            trace.push_back(page(random));
+        }
+    } else if (kind == "zipf") {
+        vector<double> cdf(pages); //cumulative weights, sampled by binary search
+        double total = 0;
+        for (Page k = 0; k < pages; k++) {
+            total += 1 / pow((double)(k + 1), config.zipfSkew);
+            cdf[k] = total;
+        }
+        uniform_real_distribution<double> weight(0, total);
+        for (long long i = 0; i < config.length; i++) {
+            Page page = (Page)(lower_bound(cdf.begin(), cdf.end(), weight(random)) - cdf.begin());
+            trace.push_back(min(page, pages - 1));
+        }
+    } else if (kind == "loop") {
+        for (long long i = 0; i < config.length; i++) {
+            trace.push_back((Page)i % pages);
+        }
+    } else if (kind == "phase") {
+        Page workingSet = max<Page>(1, pages / 20);
+        long long phaseLength = max(1LL, config.length / 10);
+        uniform_int_distribution<Page> start(0, pages - workingSet), offset(0, workingSet - 1);
+        Page base = 0;
+        for (long long i = 0; i < config.length; i++) {
+            if (i % phaseLength == 0) {
+                base = start(random); //the working set moves
+            }
+            trace.push_back(base + offset(random));
+        }
+    }
+    return trace;
+}
+
+// Time a fault count in milliseconds (best of three runs).
+template <class Run>
+double timeMs(Run run, double& faults) {
+    double best = 0;
+    for (int i = 0; i < 3; i++) {
+        auto start = chrono::steady_clock::now();
+        faults = run();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        best = i == 0 ? ms : min(best, ms);
+    }
+    return best;
+}
+
+// Microbenchmark of the two ways to run FIFO, LRU, MRU and CLOCK with 4 to 32 frames: the std::find
+// reference function and the O(1) engine through countFaults, with the engine's speedup. It runs on
+// the input repeated 'repeat' times, where nearly every reference hits, and on a zipf trace of the
+// same length, where most references miss.
+void runMicrobench(vector<Address>& data, int pageSize, int repeat) {
+    vector<Page> once = makePages(data, pageSize);
+    vector<Page> input;
+    input.reserve(once.size() * repeat);
+    for (int r = 0; r < repeat; r++) {
+        input.insert(input.end(), once.begin(), once.end());
+    }
+    BenchConfig zipf;
+    zipf.length = (long long)input.size();
+
+    struct Kernels {
+        string name;
+        double (*find)(const vector<Page>&, int);
+        double (*engine)(const vector<Page>&, int);
+    };
+    const Kernels kernels[] = {
+        {"FIFO", fifoReplacement, countFaults<FifoEngine>},
+        {"LRU", lruReplacement, countFaults<LruEngine>},
+        {"MRU", mruReplacement, countFaults<MruEngine>},
+        {"CLOCK", clockReplacement, countFaults<ClockEngine>},
+    };
+    for (int t = 0; t < 2; t++) {
+        vector<Page> pages = t == 0 ? input : generateTrace("zipf", zipf);
+        if (t == 0) {
+            cout << "input: " << pages.size() << " references, page size " << pageSize << endl;
+        } else {
+            cout << "zipf: " << pages.size() << " references over " << zipf.pages << " pages" << endl;
+        }
+        cout << setw(10) << "Algorithm" << setw(10) << "# Frames" << setw(10) << "Fault %" << setw(16) << "std::find ms"
+             << setw(14) << "Engine ms" << setw(12) << "Speedup" << endl;
+        for (const Kernels& kernel : kernels) {
+            for (int frames : {4, 8, 12, 16, 32}) {
+                double findFaults, engineFaults;
+                double findMs = timeMs([&]() { return kernel.find(pages, frames); }, findFaults);
+                double engineMs = timeMs([&]() { return kernel.engine(pages, frames); }, engineFaults);
+                cout << setw(10) << kernel.name << setw(10) << frames << setw(10) << engineFaults / pages.size() * 100
+                     << setw(16) << findMs << setw(14) << engineMs << setw(11) << findMs / engineMs << "x";
+                if (findFaults != engineFaults) {
+                    cout << "  fault counts differ!";
+                }
+                cout << endl;
+            }
+        }
+        cout << endl;
+    }
+}
+
+// Value in KB of a field such as "VmRSS:" in /proc/self/status (-1 where it cannot be read).
+long procStatusKB(const string& field) {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, field.size(), field) == 0) {
+            return atol(line.c_str() + field.size());
+        }
+    }
+    return -1;
+}
+
+// Extra resident memory in KB that one call of run() needed at its peak, so each engine is
+// measured on its own rather than by the process's peak so far. The kernel's high-water mark is
+// reset first (Linux only); returns -1 without calling run() where that is not possible.
+template <typename Run>
+long runFootprintKB(Run run) {
+#ifdef __linux__
+#ifdef __GLIBC__
+    malloc_trim(0); //give freed heap back, so run() cannot reuse pages that are already resident
+#endif
+    ofstream reset("/proc/self/clear_refs");
+    reset << "5" << flush; //"5" resets VmHWM to the current resident size
+    long before = procStatusKB("VmRSS:");
+    if (reset.good() && before >= 0) {
+        run();
+        long peak = procStatusKB("VmHWM:");
+        if (peak >= 0) {
+            return max(0L, peak - before);
+        }
+    }
+#endif
+    return -1;
+}
+
+// Benchmark and regression run: for every synthetic trace, frame count and algorithm, check the
+// fault count against the algorithm's reference implementation on a prefix of the trace, then time
+// 'warmup' + 'repetitions' runs over the whole trace and report the median in million references
+// per second, plus the resident memory one fresh run needed. Returns 1 if any check fails.
+int runBench(const BenchConfig& bench, const SweepConfig& config) {
+    vector<const Algorithm*> selected;
+    if (!selectAlgorithms(config, false, selected)) {
+        return 1;
+    }
+    ofstream csv;
+    if (!config.csvPath.empty()) {
+        csv.open(config.csvPath);
+        if (!csv.is_open()) {
+            cerr << "Could not open the file: " << config.csvPath << endl;
+            return 1;
+        }
+        csv << "trace,references,pages,frames,algorithm,faults,fault_pct,mrefs_per_sec,best_mrefs_per_sec,run_rss_kb,check\n";
+    }
+
+    bool failed = false;
+    for (const string& kind : bench.traces) {
+        PageTrace trace; //nextUse left empty, so Optimal's timing includes its next-use pass
+        trace.pages = generateTrace(kind, bench);
+        if (trace.pages.empty()) {
+            cerr << "Unknown trace: " << kind << " (use uniform, zipf, loop or phase)" << endl;
+            return 1;
+        }
+        trace.numPages = countUniquePages(trace.pages);
+        double references = (double)trace.pages.size();
+        cout << kind << ": " << trace.pages.size() << " references, " << trace.numPages << " distinct pages" << endl;
+        cout << setw(10) << "# Frames" << setw(12) << "Algorithm" << setw(14) << "Fault %" << setw(14) << "Mrefs/s"
+             << setw(14) << "Best Mrefs/s" << setw(14) << "Run RSS MB" << "  Check" << endl;
 
-    faults[0] = ((fifoReplacement(pages, frames)/data.size() * 100)); //returns how many page faults will occur from FIFO page replacement
-    faults[1] = ((lruReplacement(pages, frames)/data.size() * 100));//returns how many page faults will occur from LRU page replacement
-    faults[2] = ((mruReplacement(pages, frames)/data.size() * 100));//returns how many page faults will occur from MRU page replacement
-    faults[3] = ((optimalReplacement(pages, frames)/data.size() * 100));//returns how many page faults will occur from optimal page replacement
-    print(pageSize, numPages, frames, faults); //prints the fault information in a table format.
+        for (int frames : config.frames) {
+            for (const Algorithm* algorithm : selected) {
+                // Regression check on a prefix (Optimal's reference rescans the rest of the trace
+                // for every frame on every fault, so it gets a quarter of the prefix).
+                string check = "-";
+                long long limit = algorithm->needsNextUse ? bench.checkLength / 4 : bench.checkLength;
+                if (limit > 0 && algorithm->reference) {
+                    PageTrace prefix;
+                    prefix.pages.assign(trace.pages.begin(), trace.pages.begin() + min<long long>(limit, trace.pages.size()));
+                    double expected = algorithm->reference(prefix.pages, frames);
+                    double actual = algorithm->run(prefix, frames);
+                    if (actual == expected) {
+                        check = "ok";
+                    } else {
+                        ostringstream message;
+                        message << "FAIL (" << (long long)actual << " faults, reference " << (long long)expected << ")";
+                        check = message.str();
+                        failed = true;
+                    }
+                }
+
+                double faults = 0;
+                for (int i = 0; i < bench.warmup; i++) {
+                    faults = algorithm->run(trace, frames);
+                }
+                vector<double> seconds;
+                for (int i = 0; i < bench.repetitions; i++) {
+                    auto start = chrono::steady_clock::now();
+                    faults = algorithm->run(trace, frames);
+                    seconds.push_back(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+                }
+                sort(seconds.begin(), seconds.end());
+                double rate = references / max(seconds[seconds.size() / 2], 1e-9) / 1e6;
+                double bestRate = references / max(seconds[0], 1e-9) / 1e6;
+                long footprint = runFootprintKB([&] { algorithm->run(trace, frames); }); //an extra, untimed run
+
+                cout << setw(10) << frames << setw(12) << algorithm->name << setw(14) << faults / references * 100
+                     << setw(14) << rate << setw(14) << bestRate << setw(14);
+                if (footprint >= 0) {
+                    cout << footprint / 1024.0;
+                } else {
+                    cout << "n/a";
+                }
+                cout << "  " << check << endl;
+                if (csv.is_open()) {
+                    csv << kind << "," << trace.pages.size() << "," << trace.numPages << "," << frames << ","
+                        << algorithm->name << "," << (long long)faults << "," << faults / references * 100 << ","
+                        << rate << "," << bestRate << "," << footprint << "," << check << "\n";
+                }
+            }
+        }
+        cout << endl;
+    }
+    if (failed) {
+        cerr << "Fault counts differ from the reference implementation" << endl;
+    }
+    return failed ? 1 : 0;
 }
 
 // Main function
-int main() {
-    vector<int> data; //A vector to store the input information
-    readFile("input.txt", data); //reads in a text file (defaulted to input.txt) as a list of byte addresses and stores it
-    runAlgorithms(data); // runs through the different algorthims and prints the page faults of each to the terminal.
+// Usage: PageReplacement [--input FILE]
+//        PageReplacement --mrc [--input FILE] [--page-size N] [--max-frames N]   (O(references * max frames))
+//        PageReplacement --sweep [--input FILE] [--page-sizes N,..] [--frames N,..] [--algorithms NAME,..] [--threads N] [--csv FILE] [--stream]
+//        PageReplacement --convert OUT [--input FILE] [--encoding fixed|varint]
+//        PageReplacement --microbench [--input FILE] [--page-size N] [--repeat N]
+//        PageReplacement --bench [--traces NAME,..] [--length N] [--pages N] [--zipf-s X] [--frames N,..]
+//                        [--algorithms NAME,..] [--warmup N] [--reps N] [--check N] [--seed N] [--csv FILE]
+int main(int argc, char* argv[]) {
+    string input = "input.txt"; //text file of byte addresses, one per line
+    bool missCurve = false;     //print LRU/OPT miss-ratio curves instead of the four-algorithm table
+    bool sweep = false;         //run every combination of the lists in 'config'
+    SweepConfig config;
+    int pageSize = 2048;        //page size for --mrc
+    int maxFrames = 0;          //largest frame count for --mrc (0 = distinct pages, at most MRC_DEFAULT_FRAMES)
+    bool stream = false;        //--sweep reads the trace chunk by chunk instead of loading it
+    string convertPath;         //write the input as a binary trace here and exit
+    uint32_t encoding = TRACE_VARINT;
+    bool microbench = false;    //time the frames search kernels instead of printing the table
+    int repeat = 1000;          //--microbench: how many times to repeat the input
+    bool bench = false;         //benchmark the engines on synthetic traces
+    BenchConfig benchConfig;
+    bool framesGiven = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input = argv[++i];
+        } else if (strcmp(argv[i], "--mrc") == 0) {
+            missCurve = true;
+        } else if (strcmp(argv[i], "--page-size") == 0 && i + 1 < argc) {
+            pageSize = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--max-frames") == 0 && i + 1 < argc) {
+            maxFrames = max(0, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--sweep") == 0) {
+            sweep = true;
+        } else if (strcmp(argv[i], "--page-sizes") == 0 && i + 1 < argc && parseList(argv[i + 1], config.pageSizes)) {
+            i++;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc && parseList(argv[i + 1], config.frames)) {
+            framesGiven = true;
+            i++;
+        } else if (strcmp(argv[i], "--algorithms") == 0 && i + 1 < argc && parseList(argv[i + 1], config.algorithms)) {
+            i++;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            config.threads = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            config.csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--microbench") == 0) {
+            microbench = true;
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            bench = true;
+        } else if (strcmp(argv[i], "--traces") == 0 && i + 1 < argc && parseList(argv[i + 1], benchConfig.traces)) {
+            i++;
+        } else if (strcmp(argv[i], "--length") == 0 && i + 1 < argc) {
+            benchConfig.length = max(1LL, atoll(argv[++i]));
+        } else if (strcmp(argv[i], "--pages") == 0 && i + 1 < argc) {
+            benchConfig.pages = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--zipf-s") == 0 && i + 1 < argc) {
+            benchConfig.zipfSkew = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            benchConfig.warmup = max(0, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            benchConfig.repetitions = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+            benchConfig.checkLength = max(0LL, atoll(argv[++i]));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            benchConfig.seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream = true;
+        } else if (strcmp(argv[i], "--convert") == 0 && i + 1 < argc) {
+            convertPath = argv[++i];
+        } else if (strcmp(argv[i], "--encoding") == 0 && i + 1 < argc
+                   && (strcmp(argv[i + 1], "fixed") == 0 || strcmp(argv[i + 1], "varint") == 0)) {
+            encoding = strcmp(argv[++i], "fixed") == 0 ? TRACE_FIXED : TRACE_VARINT;
+        } else {
+            cerr << "Usage: " << argv[0] << " [--input FILE]\n"
+                 << "   or: " << argv[0] << " --mrc [--input FILE] [--page-size N] [--max-frames N]\n"
+                 << "                (takes O(references * max frames); max frames defaults to min(distinct pages, " << MRC_DEFAULT_FRAMES << "))\n"
+                 << "   or: " << argv[0] << " --sweep [--input FILE] [--page-sizes N,..] [--frames N,..] [--algorithms NAME,..] [--threads N] [--csv FILE] [--stream]\n"
+                 << "   or: " << argv[0] << " --convert OUT [--input FILE] [--encoding fixed|varint]\n"
+                 << "   or: " << argv[0] << " --microbench [--input FILE] [--page-size N] [--repeat N]\n"
+                 << "   or: " << argv[0] << " --bench [--traces NAME,..] [--length N] [--pages N] [--zipf-s X] [--frames N,..]\n"
+                 << "                [--algorithms NAME,..] [--warmup N] [--reps N] [--check N] [--seed N] [--csv FILE]\n";
+            return 1;
+        }
+    }
+
+    if (bench) {
+        if (!framesGiven) {
+            config.frames = {4, 12, 64, 1024}; //a few frames up to a large cache
+        }
+        return runBench(benchConfig, config); //synthetic traces, no input file
+    }
+    if (!convertPath.empty()) {
+        return convertTrace(input, convertPath, encoding); //text or binary trace -> binary trace
+    }
+    if (sweep && stream) {
+        return runStreamingSweep(input, config); //same table, trace never held in memory
+    }
+
+    vector<Address> data; //A vector to store the input information
+    readFile(input, data); //reads in a text file (defaulted to input.txt) as a list of byte addresses and stores it
+    if (microbench) {
+        runMicrobench(data, pageSize, repeat); //std::find loop vs O(1) engine
+    } else if (sweep) {
+        return runSweep(data, config); //every page size / frames / algorithm combination, in parallel
+    } else if (missCurve) {
+        runMissCurve(data, pageSize, maxFrames); //fault % for every frame count from one pass per algorithm
+    } else {
+        runAlgorithms(data); // runs through the different algorthims and prints the page faults of each to the terminal.
+    }
     return 0;
 }